@@ -1,106 +0,0 @@
-// Auto-generated file for embedded shader sources
-
-const char* shader_ui_v = 
-"#version 330 core\n"
-"\n"
-"layout (location = 0) in vec2 aPos;\n"
-"layout (location = 1) in vec3 aColor;\n"
-"\n"
-"uniform mat4 uProjection;\n"
-"out vec3 ourColor;\n"
-"\n"
-"void main(){\n"
-"    gl_Position = uProjection * vec4(aPos, 0.0, 1.0);\n"
-"    ourColor = aColor;\n"
-"}\n";
-
-const char* shader_ui_f = 
-"#version 330 core\n"
-"\n"
-"in vec3 ourColor;\n"
-"out vec4 FragColor;\n"
-"\n"
-"uniform vec3 uColor;\n"
-"\n"
-"void main(){\n"
-"    if(uColor.r > 0)\n"
-"        FragColor = vec4(uColor, 1.0);\n"
-"    else\n"
-"        FragColor = vec4(ourColor, 1.0);\n"
-"}\n";
-
-const char* shader_game_v = 
-"#version 330 core\n"
-"    layout (location = 0) in vec2 aPos;   // vertex position\n"
-"    layout (location = 1) in vec3 iColor; // color defined in instance\n"
-"    layout (location = 2) in vec3 iPos;   // position shift and vertical flip defined in instance\n"
-"    layout (location = 3) in float iState;// state (0/1) defined in instance\n"
-"    uniform mat4 uProjection;             // projection matrix for viewport setup\n"
-"    uniform vec3 uColor;                  // if need to override instance color \n"
-"                                          //   (example: for wireframe grid has to in one color)\n"
-"    uniform float uState;                 // if need to override instance state \n"
-"                                          //   (example: for wireframe need be draw all instances -\n"
-"                                          //   so state=on for all, for solid mode -\n"
-"                                          //   need to draw only instances with state=on)\n"
-"    uniform float uShape;\n"
-"    out vec3 fragColor;\n"
-"    out float fragState;\n"
-"    \n"
-"    out vec2 texCoord;\n"
-"\n"
-"    mat4 flip = mat4(\n"
-"      1.0, 0.0, 0.0, 0.0, \n"
-"      0.0, iPos.z, 0.0, 0.0, \n"
-"      0.0, 0.0, 1.0, 0.0,\n"
-"      iPos.x, iPos.y, 0.0, 1.0);\n"
-"    \n"
-"    vec2 textureCoord[13] = vec2[](\n"
-"      // Tetragon\n"
-"      vec2(0.0f, 0.0f),\n"
-"      vec2(1.0f, 0.0f),\n"
-"      vec2(1.0f, 1.0f),\n"
-"      vec2(0.0f, 1.0f),\n"
-"      // Trigon\n"
-"      vec2(0.0f, 0.0f),\n"
-"      vec2(1.0f, 0.0f),\n"
-"      vec2(0.5f, 0.8f),\n"
-"      // Hexagon\n"
-"      vec2(0.5f, 0.0f),\n"
-"      vec2(1.0f, 0.25f),\n"
-"      vec2(1.0f, 0.75f),\n"
-"      vec2(0.5f, 1.0f),\n"
-"      vec2(0.0f, 0.75f),\n"
-"      vec2(0.0f, 0.25f)\n"
-"    );\n"
-"\n"
-"    void main() {\n"
-"        gl_Position = uProjection * flip * vec4(aPos, 0.0, 1.0);\n"
-"        fragColor = uColor.x > 0 ? uColor : iColor;\n"
-"        fragState = uState > -1 ? uState : iState;\n"
-"        if(uShape == 0.0)\n"
-"          texCoord = textureCoord[gl_VertexID];\n"
-"        else if(uShape == 1.0)\n"
-"          texCoord = textureCoord[gl_VertexID + 4];\n"
-"        else \n"
-"          texCoord = textureCoord[gl_VertexID + 7];\n"
-"    };\n";
-
-const char* shader_game_f = 
-"#version 330 core\n"
-"in vec3 fragColor;\n"
-"in float fragState;\n"
-"in vec2 texCoord;\n"
-"uniform sampler2D uGridTexture;\n"
-"out vec4 FragColor;\n"
-"\n"
-"void main() {\n"
-"    if(fragState < 0.5){ \n"
-"      discard; \n"
-"    } else if(fragState < 1.0){ \n"
-"      FragColor = texture(uGridTexture, texCoord);\n"
-"    } else { \n"
-"      FragColor = vec4(fragColor, 1.0);\n"
-"    }\n"
-"};\n"
-"    \n";
-
@@ -1,44 +0,0 @@
-// Auto-generated file for embedded shapes sources
-
-const float vertices_tetragon[8] = {
-	-0.5000f, 0.5000f, 0.5000f, 0.5000f, 0.5000f, -0.5000f, -0.5000f, -0.5000f, 
-};
-const unsigned char indices_w_tetragon[8] = {
-	0, 1, 1, 2, 2, 3, 3, 0, 
-};
-const unsigned char indices_s_tetragon[6] = {
-	0, 1, 2, 1, 2, 3, 
-};
-const float vertices_trigon[6] = {
-	-0.5000f, 0.4280f, 0.5000f, 0.4280f, 0.0000f, -0.4280f, 
-};
-const unsigned char indices_w_trigon[6] = {
-	0, 1, 1, 2, 2, 0, 
-};
-const unsigned char indices_s_trigon[3] = {
-	0, 1, 2, 
-};
-const float vertices_hexagon[12] = {
-	-0.4340f, 0.2490f, 0.0000f, 0.5000f, 0.4340f, 0.2490f, 0.4340f, -0.2490f, 0.0000f, -0.5000f, -0.4340f, -0.2490f, 
-};
-const unsigned char indices_w_hexagon[12] = {
-	0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 0, 
-};
-const unsigned char indices_s_hexagon[12] = {
-	0, 1, 2, 1, 2, 3, 2, 3, 4, 3, 4, 5, 
-};
-const float vertices_shapes[26] = {
-	-0.5000f, 0.5000f, 0.5000f, 0.5000f, 0.5000f, -0.5000f, -0.5000f, -0.5000f, 
-	-0.5000f, 0.4280f, 0.5000f, 0.4280f, 0.0000f, -0.4280f, 
-	-0.4340f, 0.2490f, 0.0000f, 0.5000f, 0.4340f, 0.2490f, 0.4340f, -0.2490f, 0.0000f, -0.5000f, -0.4340f, -0.2490f, 
-};
-const unsigned char indices_w_shapes[26] = {
-	0, 1, 1, 2, 2, 3, 3, 0, 
-	4, 5, 5, 6, 6, 4, 
-	7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 7, 
-};
-const unsigned char indices_s_shapes[21] = {
-	0, 1, 2, 1, 2, 3, 
-	4, 5, 6, 
-	7, 8, 9, 8, 9, 10, 9, 10, 11, 10, 11, 12, 
-};
@@ -0,0 +1,210 @@
+#include "utils.h"
+#include <time.h>
+
+/*
+  Headless benchmark of the step kernels
+
+    ./build/program bench [generations]
+
+  Every kernel supported by the mode steps the same random soup
+  (generations + 1 warm up step), population after the run is printed
+  as well, it has to be the same for all kernels of the mode.
+*/
+
+double now_ms(){
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static int population(Grid g){
+  int result = 0;
+  for(int i = 0; i < g.rows * g.cols; i++)
+    result += g.data[i].state == 1.0;
+  return result;
+}
+
+void bench(int generations){
+  const Mode modes[] = { TETRAGON, HEXAGON, TRIGON };
+  const char* mode_names[] = { "trigon", "tetragon", "hexagon" };
+  const int sizes[] = { 256, 1024, 4096 };
+  Rule rule = rule_from_uor(2, 3, 3);
+
+  printf("%-9s %-10s %-11s %12s %12s %10s\n",
+    "mode", "size", "kernel", "ms/gen", "Mcells/s", "population");
+
+  for(int m = 0; m < 3; m++)
+    for(int s = 0; s < 3; s++){
+      Grid soup = {};
+      grid_init(&soup, modes[m], sizes[s], sizes[s]);
+      srand(1);
+      for(int i = 0; i < soup.rows * soup.cols; i++)
+        soup.data[i].state = rand() % 3 == 0;
+
+      for(Kernel k = CELLS; k <= LTL; k++){
+        // reference kernels would take minutes on big grids, graph
+        // adjacency of them - gigabytes
+        if((k == CELLS || k == PLANE || k == GRAPH) && sizes[s] > 1024)
+          continue;
+
+        Grid grid = {};
+        grid_init(&grid, soup.mode, soup.rows, soup.cols);
+        for(int i = 0; i < grid.rows * grid.cols; i++)
+          grid.data[i].state = soup.data[i].state;
+
+        Engine e = {};
+        if(!engine_init(&e, k, grid)){
+          free(grid.data);
+          continue;
+        }
+
+        engine_step(&e, rule);    // warm up, rule tables are built here
+
+        double start = now_ms();
+        engine_run(&e, rule, generations);
+        double elapsed = now_ms() - start;
+        engine_store(&e, grid);
+
+        char size[16];
+        snprintf(size, sizeof(size), "%dx%d", grid.rows, grid.cols);
+        printf("%-9s %-10s %-11s %12.3f %12.1f %10d\n",
+          mode_names[modes[m]], size, kernel_name(k),
+          elapsed / generations,
+          (double)grid.rows * grid.cols * generations / elapsed / 1000.0,
+          population(grid));
+
+        engine_destroy(&e);
+        free(grid.data);
+      }
+      free(soup.data);
+    }
+
+  // random fill straight into the bitboard, the same at any thread count
+  const double densities[] = { 0.5, 0.3 };
+  Bitboard b = {};
+  bitboard_init(&b, TETRAGON, 16384, 16384);
+  for(int d = 0; d < 2; d++){
+    double start = now_ms();
+    long alive = bitboard_random(&b, 1, densities[d], pool_shared());
+    double elapsed = now_ms() - start;
+    printf("random fill 16384x16384 density %.2f: %.1f ms, %.1f Mcells/s, population %ld\n",
+      densities[d], elapsed, 16384.0 * 16384 / elapsed / 1000.0, alive);
+  }
+  bitboard_destroy(&b);
+
+  // Larger than Life, step cost has to stay the same as the radius grows
+  for(int m = 1; m < 3; m++){
+    Grid grid = {};
+    grid_init(&grid, modes[m - 1], 1024, 1024);
+    grid_random(grid, 1, 0.5);
+    Engine e = {};
+    engine_init(&e, LTL, grid);
+    for(int radius = 1; radius <= 16; radius *= 2){
+      // Bosco's rule scaled by the neighborhood size
+      int size = modes[m - 1] == HEXAGON ? 3 * radius * (radius + 1) + 1 : (2 * radius + 1) * (2 * radius + 1);
+      Rule ltl = {
+        .radius = radius,
+        .middle = 1,
+        .births = { size * 34 / 121, size * 45 / 121 },
+        .survivals = { size * 33 / 121, size * 57 / 121 }
+      };
+      engine_load(&e, grid);
+      double start = now_ms();
+      engine_run(&e, ltl, generations);
+      double elapsed = now_ms() - start;
+      printf("ltl %-8s 1024x1024 radius %2d: %8.3f ms/gen\n",
+        mode_names[modes[m - 1]], radius, elapsed / generations);
+    }
+    engine_destroy(&e);
+    free(grid.data);
+  }
+
+  // Lenia, FFT convolution - the same cost for any kernel radius,
+  // power of two and other sizes
+  const int lenia_sizes[][2] = { { 256, 256 }, { 480, 960 }, { 1024, 1024 } };
+  for(int s = 0; s < 3; s++){
+    Grid grid = {};
+    grid_init(&grid, TETRAGON, lenia_sizes[s][0], lenia_sizes[s][1]);
+    Engine e = {};
+    engine_init(&e, LENIA, grid);
+    for(int radius = 13; radius <= 52; radius *= 2){
+      Rule lenia = rule_lenia_default();
+      lenia.radius = radius;
+      engine_random(&e, 1, 0.5, NULL);
+      engine_step(&e, lenia);   // kernel spectrum is built here
+      double start = now_ms();
+      engine_run(&e, lenia, generations);
+      double elapsed = now_ms() - start;
+      printf("lenia %4dx%-4d radius %2d: %8.3f ms/gen\n",
+        grid.rows, grid.cols, radius, elapsed / generations);
+    }
+    engine_destroy(&e);
+    free(grid.data);
+  }
+
+  // every tiling of tilings.svg, the same CSR stepping for any of them
+  for(int t = 0; tiling_get(t); t++){
+    const Tiling* tiling = tiling_get(t);
+    Grid grid = {};
+    grid_init(&grid, TETRAGON, 1024, 1024);
+    grid_random(grid, 1, 0.3);
+    Graph g = {};
+    graph_init_tiling(&g, tiling, grid.rows, grid.cols);
+    graph_load(&g, grid);
+    graph_step(&g, pool_shared(), rule);
+    double start = now_ms();
+    for(int i = 0; i < generations; i++)
+      graph_step(&g, pool_shared(), rule);
+    double elapsed = now_ms() - start;
+    graph_store(&g, grid);
+    printf("graph %-12s 1024x1024: %8.3f ms/gen, population %d\n",
+      tiling->name, elapsed / generations, population(grid));
+    graph_destroy(&g);
+    free(grid.data);
+  }
+
+  // Margolus block rules, 32 blocks per word pair on the pool
+  const char* block_rules[] = { "critters", "tron", "billiard" };
+  for(int s = 0; s < 3; s++){
+    Grid grid = {};
+    grid_init(&grid, TETRAGON, 2048, 2048);
+    grid_random(grid, 1, 0.1);
+    Engine e = {};
+    engine_init(&e, MARGOLUS, grid);
+    Rule blocks = {};
+    rule_from_blocks(block_rules[s], &blocks);
+    double start = now_ms();
+    engine_run(&e, blocks, generations);
+    double elapsed = now_ms() - start;
+    printf("margolus %-8s 2048x2048: %8.3f ms/gen\n", block_rules[s], elapsed / generations);
+    engine_destroy(&e);
+    free(grid.data);
+  }
+
+  // rules compiled into kernels (resources/rules.txt) against the same
+  // rules stepped by the expression
+  const Rule compiled[] = {
+    rule_from_uor(2, 3, 3),
+    { .birth = 0x1c8, .survive = 0x1d8 }    // B3678/S34678
+  };
+  const char* compiled_names[] = { "B3/S23", "B3678/S34678" };
+  for(int m = 0; m < 3; m++)
+    for(int r = 0; r < 2; r++){
+      double ms[2];
+      for(int k = 0; k < 2; k++){
+        Bitboard b = {};
+        bitboard_init(&b, modes[m], 2048, 2048);
+        bitboard_random(&b, 1, 0.5, NULL);
+        bitboard_rule(&b, compiled[r]);
+        if(k)
+          b.kernel = NULL;
+        double start = now_ms();
+        for(int i = 0; i < generations; i++)
+          bitboard_step(&b, compiled[r]);
+        ms[k] = (now_ms() - start) / generations;
+        bitboard_destroy(&b);
+      }
+      printf("compiled %-8s %-13s 2048x2048: %8.3f ms/gen, expression %8.3f ms/gen\n",
+        mode_names[modes[m]], compiled_names[r], ms[0], ms[1]);
+    }
+}
@@ -0,0 +1,433 @@
+#include "utils.h"
+
+/*
+  Bitboard - 64 cells per word, stepped with bit-sliced arithmetic
+
+  Row is stored as `words` 64 bit words, bit j of word w is column
+  w * 64 + j. Each row has one zero word on both sides, and there is one
+  zero row above and two below the grid (second one is for 2x2 blocks of
+  lut_step()), so neighbor words can be read without bounds checks.
+
+  Neighbor in the next / previous column is a whole-row shift by one bit
+  with the carry taken from the adjacent word:
+
+    east(row)[w] = row[w] >> 1 | row[w + 1] << 63    (col + 1)
+    west(row)[w] = row[w] << 1 | row[w - 1] >> 63    (col - 1)
+
+  Then neighbor count for 64 cells at once is calculated with an adder
+  tree over the shifted rows, giving count as bit planes, and the rule is
+  applied with its boolean expression (see rule_compile()). Rules of
+  resources/rules.txt are compiled by the preprocessor into kernels.h
+  instead: the same row steppers with a straight-line expression of the
+  rule inlined, picked by the mode and the masks when the rule is set.
+
+  With `hashing` on, Zobrist hash of the states (see cycle.c) is kept by
+  edits and steps, with `tracking` - statistics of a step (stats.c).
+  Bitboard hashes whole words: key of a word depends on its position and
+  its bits, a stepped row is diffed against the previous one right after
+  it is written, and only words with flips are hashed again - nothing at
+  all for settled parts of the grid.
+*/
+
+static inline uint64_t east(const uint64_t* row, int w){
+  return row[w] >> 1 | row[w + 1] << 63;
+}
+
+static inline uint64_t west(const uint64_t* row, int w){
+  return row[w] << 1 | row[w - 1] >> 63;
+}
+
+static inline uint64_t east2(const uint64_t* row, int w){
+  return row[w] >> 2 | row[w + 1] << 62;
+}
+
+static inline uint64_t west2(const uint64_t* row, int w){
+  return row[w] << 2 | row[w - 1] >> 62;
+}
+
+uint64_t* bitboard_row(Bitboard* b, int row){
+  return b->data + (row + 1) * b->stride + 1;
+}
+
+int bitboard_init(Bitboard* b, Mode mode, int rows, int cols){
+  b->mode = mode;
+  b->rows = rows;
+  b->cols = cols;
+  b->words = (cols + 63) / 64;
+  b->stride = b->words + 2;
+  b->tail = cols % 64 ? (1ull << (cols % 64)) - 1 : ~0ull;
+  b->data = calloc(sizeof(uint64_t), b->stride * (rows + 3));
+  b->next = calloc(sizeof(uint64_t), b->stride * (rows + 3));
+  b->expr.size = -1;   // rule is compiled on the first step
+  return 1;
+}
+
+void bitboard_destroy(Bitboard* b){
+  free(b->data);
+  free(b->next);
+  free(b->table);
+  *b = (Bitboard){};
+}
+
+void bitboard_set(Bitboard* b, int row, int col, unsigned char value){
+  uint64_t* w = bitboard_row(b, row) + col / 64;
+  uint64_t was = *w;
+  if(value)
+    *w |= 1ull << (col % 64);
+  else
+    *w &= ~(1ull << (col % 64));
+  if(b->hashing)
+    b->hash ^= zobrist_word(w - b->data, was) ^ zobrist_word(w - b->data, *w);
+}
+
+unsigned char bitboard_get(Bitboard* b, int row, int col){
+  return (bitboard_row(b, row)[col / 64] >> (col % 64)) & 1;
+}
+
+void bitboard_load(Bitboard* b, Grid in){
+  for(int i = 0; i < in.rows; i++)
+    for(int j = 0; j < in.cols; j++)
+      bitboard_set(b, i, j, in.data[i * in.cols + j].state == 1.0);
+}
+
+/*
+  Flips between two versions of a row - hash change (with `hashing`),
+  births, deaths and the box of alive cells (with `tracking`).
+  Rows may live anywhere (rings of temporal blocking), words are keyed
+  by the grid position.
+  Unchanged rows are skipped by a vectorizable or of the diffs, changed
+  words are gathered without branches (half of the words changing in a
+  busy soup would be a mispredicted branch each).
+*/
+void bitboard_tally_row(
+  Bitboard* b,
+  const uint64_t* was,
+  const uint64_t* now,
+  int from,
+  int to,
+  int row,
+  Tally* t){
+    if(b->tracking){
+      int first = from, last = to - 1;
+      while(first < to && !now[first])
+        first++;
+      if(first < to){
+        while(!now[last])
+          last--;
+        box_add(&t->alive, row, first * 64 + __builtin_ctzll(now[first]));
+        box_add(&t->alive, row, last * 64 + 63 - __builtin_clzll(now[last]));
+      }
+    }
+
+    uint64_t any = 0;
+    for(int w = from; w < to; w++)
+      any |= was[w] ^ now[w];
+    if(!any)
+      return;
+
+    long base = (long)(row + 1) * b->stride + 1;
+    int changed[64];
+    uint64_t hash = 0;
+    long births = 0, deaths = 0;
+    for(int start = from; start < to; start += 64){
+      int end = start + 64 < to ? start + 64 : to;
+      int size = 0;
+      for(int w = start; w < end; w++){
+        changed[size] = w;
+        size += was[w] != now[w];
+      }
+      if(b->hashing)
+        for(int i = 0; i < size; i++){
+          int w = changed[i];
+          hash ^= zobrist_word(base + w, was[w]) ^ zobrist_word(base + w, now[w]);
+        }
+      if(b->tracking)
+        for(int i = 0; i < size; i++){
+          int w = changed[i];
+          births += popcount(now[w] & ~was[w]);
+          deaths += popcount(was[w] & ~now[w]);
+        }
+    }
+    t->hash ^= hash;
+    t->births += births;
+    t->deaths += deaths;
+}
+
+/*
+  Box of alive cells in the rows of `within`
+*/
+Box bitboard_box(Bitboard* b, Box within){
+  Tally t = tally_empty();
+  int tracking = b->tracking, hashing = b->hashing;
+  b->tracking = 1;
+  b->hashing = 0;
+  for(int i = within.top > 0 ? within.top : 0; i <= within.bottom && i < b->rows; i++){
+    const uint64_t* row = bitboard_row(b, i);
+    bitboard_tally_row(b, row, row, 0, b->words, i, &t);
+  }
+  b->tracking = tracking;
+  b->hashing = hashing;
+  return t.alive;
+}
+
+/*
+  Hash from scratch, when hashing is turned on
+*/
+uint64_t bitboard_hash(Bitboard* b){
+  uint64_t hash = 0;
+  for(int i = 0; i < b->rows; i++){
+    const uint64_t* row = bitboard_row(b, i);
+    for(int w = 0; w < b->words; w++)
+      hash ^= zobrist_word(row + w - b->data, row[w]);
+  }
+  return hash;
+}
+
+void bitboard_store(Bitboard* b, Grid out){
+  for(int i = 0; i < out.rows; i++){
+    const uint64_t* row = bitboard_row(b, i);
+    for(int j = 0; j < out.cols; j++)
+      out.data[i * out.cols + j].state = (row[j / 64] >> (j % 64)) & 1;
+  }
+}
+
+/*
+  Row steppers get the rule as a function of the count bit planes and
+  the state - rule_eval() of the expression, or a straight-line one from
+  kernels.h. Steppers are always inlined, so that function is a constant
+  there and is inlined into the loop too.
+*/
+typedef uint64_t (*RuleFunction)(const RuleExpr* e, const uint64_t v[RULE_VARS]);
+
+/*
+  Tetragon neighbors - 3 words from the rows above and below and
+  2 from the same row, reduced by full adders into 4 bit planes
+*/
+static inline __attribute__((always_inline)) void step_row_tetragon(
+  const uint64_t* u,
+  const uint64_t* c,
+  const uint64_t* d,
+  uint64_t* out,
+  int from,
+  int to,
+  const RuleExpr* expr,
+  RuleFunction eval){
+
+    for(int w = from; w < to; w++){
+      uint64_t s0, s1, s2, c0, c1, c2, k0, e, f, g, v[RULE_VARS];
+      full_add(east(c, w), west(c, w), u[w], &s0, &c0);
+      full_add(east(u, w), west(u, w), d[w], &s1, &c1);
+      half_add(east(d, w), west(d, w), &s2, &c2);
+      full_add(s0, s1, s2, &v[0], &k0);
+      full_add(c0, c1, c2, &e, &f);
+      half_add(e, k0, &v[1], &g);
+      half_add(f, g, &v[2], &v[3]);
+      v[RULE_BITS] = c[w];
+
+      out[w] = eval(expr, v);
+    }
+}
+
+/*
+  Hexagon neighbors (see neighbors_indices_hexagon()):
+  - same row:        col - 1, col + 1
+  - rows above/below: col, and col + 1 for odd rows / col - 1 for even
+
+  6 inputs are reduced with two full adders to bit 0, and carries of
+  those (weight 2) with one more full adder to bits 1 and 2.
+*/
+static inline __attribute__((always_inline)) void step_row_hexagon(
+  const uint64_t* u,
+  const uint64_t* c,
+  const uint64_t* d,
+  uint64_t* out,
+  int from,
+  int to,
+  int odd,
+  const RuleExpr* expr,
+  RuleFunction eval){
+
+    for(int w = from; w < to; w++){
+      uint64_t ud = odd ? east(u, w) : west(u, w);
+      uint64_t dd = odd ? east(d, w) : west(d, w);
+
+      uint64_t s0, c0, s1, c1, c2, v[RULE_VARS];
+      full_add(east(c, w), west(c, w), u[w], &s0, &c0);
+      full_add(d[w], ud, dd, &s1, &c1);
+      v[0] = s0 ^ s1;
+      c2 = s0 & s1;
+      full_add(c0, c1, c2, &v[1], &v[2]);
+      v[3] = 0;
+      v[RULE_BITS] = c[w];
+
+      out[w] = eval(expr, v);
+    }
+}
+
+/*
+  Trigon neighbors (see neighbors_indices_trigon()):
+  - 10 fixed:  col - 2 .. col + 2 in the same row,
+               col - 1 .. col + 1 in the rows above and below
+  - 2 by flip: col - 2, col + 2 in the row above for "up" triangles
+               (flip > 0), in the row below for "down" triangles
+
+  flip alternates with row + col, so in a word up and down triangles are
+  two interleaved planes - every other bit, starting from bit 0 in even
+  rows and from bit 1 in odd ones. The flip dependent pair is selected
+  with that mask instead of branching per cell:
+
+    pair = (above & up) | (below & ~up)
+
+  12 inputs are reduced by four full adders, bit 0 is the sum of their
+  4 sums, and their 4 carries with 2 more carries (weight 2) give bits
+  1, 2 and 3.
+*/
+static inline __attribute__((always_inline)) void step_row_trigon(
+  const uint64_t* u,
+  const uint64_t* c,
+  const uint64_t* d,
+  uint64_t* out,
+  int from,
+  int to,
+  int odd,
+  const RuleExpr* expr,
+  RuleFunction eval){
+    uint64_t up = odd ? 0xaaaaaaaaaaaaaaaaull : 0x5555555555555555ull;
+
+    for(int w = from; w < to; w++){
+      uint64_t p0 = (west2(u, w) & up) | (west2(d, w) & ~up);
+      uint64_t p1 = (east2(u, w) & up) | (east2(d, w) & ~up);
+
+      uint64_t s0, s1, s2, s3, c0, c1, c2, c3;
+      full_add(east(c, w), west(c, w), east2(c, w), &s0, &c0);
+      full_add(west2(c, w), u[w], east(u, w), &s1, &c1);
+      full_add(west(u, w), d[w], east(d, w), &s2, &c2);
+      full_add(west(d, w), p0, p1, &s3, &c3);
+
+      uint64_t t0, k0, k1, e0, e1, f0, f1, g, v[RULE_VARS];
+      full_add(s0, s1, s2, &t0, &k0);
+      half_add(t0, s3, &v[0], &k1);
+      full_add(c0, c1, c2, &e0, &f0);
+      full_add(c3, k0, k1, &e1, &f1);
+      half_add(e0, e1, &v[1], &g);
+      full_add(f0, f1, g, &v[2], &v[3]);
+      v[RULE_BITS] = c[w];
+
+      out[w] = eval(expr, v);
+    }
+}
+
+/*
+  Compiled kernels - row steppers of the rules of resources/rules.txt,
+  generated by the preprocessor
+*/
+typedef void (*RowKernel)(
+  const uint64_t* u,
+  const uint64_t* c,
+  const uint64_t* d,
+  uint64_t* out,
+  int from,
+  int to,
+  int odd);
+
+typedef struct CompiledKernel{
+  Mode mode;
+  unsigned short birth;     // masks of the counts the mode has
+  unsigned short survive;
+  const char* name;
+  RowKernel row;
+} CompiledKernel;
+
+#include "kernels.h"
+
+int neighbors_max(Mode mode){
+  switch(mode){
+    case TRIGON: return 12;
+    case HEXAGON: return 6;
+    case TETRAGON:
+    default: return 8;
+  }
+}
+
+/*
+  Steps words [from, to) of one row, window is the row with the rows
+  above and below it, `row` is the row index in the grid (parity of
+  hexagon and trigon rows depends on it), `generation` - of the window.
+  Births and survivals of a stochastic rule are then kept by the draws
+  of their cells (see random_chance()), only words with any are drawn.
+*/
+void bitboard_step_row(
+  Bitboard* b,
+  const uint64_t* window[3],
+  uint64_t* out,
+  int from,
+  int to,
+  int row,
+  int generation){
+    const uint64_t* u = window[0];
+    const uint64_t* c = window[1];
+    const uint64_t* d = window[2];
+    if(b->kernel)
+      b->kernel->row(u, c, d, out, from, to, row & 1);
+    else switch(b->mode){
+      case HEXAGON: { step_row_hexagon(u, c, d, out, from, to, row & 1, &b->expr, rule_eval); break; }
+      case TRIGON: { step_row_trigon(u, c, d, out, from, to, row & 1, &b->expr, rule_eval); break; }
+      case TETRAGON:
+      default: { step_row_tetragon(u, c, d, out, from, to, &b->expr, rule_eval); break; }
+    }
+
+    if(b->rule.stochastic){
+      uint64_t seed = counter_random(b->rule.seed, generation);
+      for(int w = from; w < to; w++)
+        if(out[w])
+          out[w] &= random_chance(seed, (uint64_t)row * b->words + w, c[w], b->chance);
+    }
+}
+
+/*
+  Compiled kernel of the rule, NULL if it is not in the list
+*/
+static const CompiledKernel* kernel_find(Mode mode, Rule rule){
+  int valid = (2 << neighbors_max(mode)) - 1;
+  for(int k = 0; k < KERNELS; k++)
+    if(kernels[k].mode == mode
+      && kernels[k].birth == (rule.birth & valid)
+      && kernels[k].survive == (rule.survive & valid))
+      return &kernels[k];
+  return NULL;
+}
+
+void bitboard_rule(Bitboard* b, Rule rule){
+  if(b->expr.size < 0
+    || rule.birth != b->rule.birth
+    || rule.survive != b->rule.survive){
+    rule_compile(rule, neighbors_max(b->mode), &b->expr);
+    b->kernel = kernel_find(b->mode, rule);
+  }
+  b->rule = rule;
+  b->chance[0] = random_threshold(rule.birth_chance);
+  b->chance[1] = random_threshold(rule.survive_chance);
+}
+
+void bitboard_step(Bitboard* b, Rule rule){
+  bitboard_rule(b, rule);
+
+  Tally t = tally_empty();
+  for(int i = 0; i < b->rows; i++){
+    const uint64_t* c = bitboard_row(b, i);
+    const uint64_t* window[3] = { c - b->stride, c, c + b->stride };
+    uint64_t* out = b->next + (c - b->data);
+    bitboard_step_row(b, window, out, 0, b->words, i, b->generation);
+    out[b->words - 1] &= b->tail;
+    if(b->hashing || b->tracking)
+      bitboard_tally_row(b, c, out, 0, b->words, i, &t);
+  }
+  b->hash ^= t.hash;
+  b->tally = t;
+  b->tally.scanned = 1;
+  b->generation++;
+
+  uint64_t* tmp = b->data;
+  b->data = b->next;
+  b->next = tmp;
+}
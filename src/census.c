@@ -0,0 +1,446 @@
+#include "utils.h"
+
+/*
+  Object census - connected groups of alive cells, counted by shape
+
+  Objects are connected components of alive cells by the mode
+  neighborhood (8 for tetragon, 6 for hexagon, 12 for trigon), labeled
+  with union-find:
+  - grid is cut into tiles, every tile is labeled on the thread pool,
+    cells are joined only with their neighbors before them in the scan
+    order and inside of the tile, so tiles never touch each other
+  - cells on the top row and the two left and right columns of a tile
+    are joined with their neighbors in the other tiles, sequentially,
+    that is only a few percent of the cells
+  - roots (the smallest cell index of the object) are found again on
+    the pool, without path compression, so nothing is written there
+
+  Every object gets a canonical hash - the same for every placement and
+  every symmetry of the lattice (8 for tetragon, 12 for hexagon and
+  trigon): cells are mapped by each symmetry, moved to the origin,
+  sorted and hashed, and the smallest hash is taken.
+  Lattice coordinates of the symmetries:
+  - tetragon - (row, col) themselves
+  - hexagon - axial (row, col - (row - (row & 1)) / 2) of the odd-r
+    layout, symmetries in cube coordinates
+  - trigon - (X, Y) = (col - 1, 3 * row + 1 + down) are the centroids
+    scaled so that a rotation by 60 degrees about a lattice vertex is
+    (X, Y) -> ((X - Y) / 2, (3 * X + Y) / 2) in integers
+*/
+
+#define CENSUS_TILE 64
+#define CENSUS_CHUNK 256    // objects hashed per task
+
+typedef struct{
+  Grid grid;
+  int steps[2][12][2];    // neighbors before the cell in the scan order
+  int degree[2];
+  int* parent;
+  int* label;
+  int* cells;             // cells of the objects, object by object
+  int* first;             // first cell of the object in `cells`
+  uint64_t* hashes;
+  int objects;
+} CensusJob;
+
+typedef struct{
+  CensusJob* job;
+  int top;
+  int left;
+} CensusTile;
+
+typedef struct{
+  CensusJob* job;
+  int from;
+  int to;
+} CensusChunk;
+
+static int census_find(int* parent, int i){
+  while(parent[i] != i){
+    parent[i] = parent[parent[i]];
+    i = parent[i];
+  }
+  return i;
+}
+
+static void census_union(int* parent, int a, int b){
+  a = census_find(parent, a);
+  b = census_find(parent, b);
+  if(a < b)
+    parent[b] = a;
+  else if(b < a)
+    parent[a] = b;
+}
+
+static int census_alive(Grid g, int row, int col){
+  return row >= 0 && row < g.rows && col >= 0 && col < g.cols
+    && g.data[row * g.cols + col].state == 1.0;
+}
+
+/*
+  Joins cells of the tile rows [top, bottom) and cols [left, right)
+  with their earlier neighbors within the same bounds
+*/
+static void census_join(
+  CensusJob* job,
+  int top,
+  int left,
+  int bottom,
+  int right,
+  int border){
+    Grid g = job->grid;
+    for(int i = top; i < bottom; i++)
+      for(int j = left; j < right; j++){
+        if(g.data[i * g.cols + j].state != 1.0)
+          continue;
+        // on the border pass only the first row and two columns on both
+        // sides of a tile, earlier neighbors of the others are in the tile
+        int col = j % CENSUS_TILE;
+        if(border && i % CENSUS_TILE && col > 1 && col < CENSUS_TILE - 2)
+          continue;
+
+        int class = neighbors_class(g.mode, i, j);
+        for(int k = 0; k < job->degree[class]; k++){
+          int r = i + job->steps[class][k][0], c = j + job->steps[class][k][1];
+          int inside = r >= top && r < bottom && c >= left && c < right;
+          int same = inside
+            && r / CENSUS_TILE == i / CENSUS_TILE
+            && c / CENSUS_TILE == j / CENSUS_TILE;
+          if(inside && (!border || !same) && census_alive(g, r, c))
+            census_union(job->parent, i * g.cols + j, r * g.cols + c);
+        }
+      }
+}
+
+static void census_tile(void* arg){
+  CensusTile* t = arg;
+  CensusJob* job = t->job;
+  Grid g = job->grid;
+  int bottom = t->top + CENSUS_TILE < g.rows ? t->top + CENSUS_TILE : g.rows;
+  int right = t->left + CENSUS_TILE < g.cols ? t->left + CENSUS_TILE : g.cols;
+
+  for(int i = t->top; i < bottom; i++)
+    for(int j = t->left; j < right; j++)
+      job->parent[i * g.cols + j] = i * g.cols + j;
+  census_join(job, t->top, t->left, bottom, right, 0);
+}
+
+static void census_roots(void* arg){
+  CensusTile* t = arg;
+  CensusJob* job = t->job;
+  Grid g = job->grid;
+  int bottom = t->top + CENSUS_TILE < g.rows ? t->top + CENSUS_TILE : g.rows;
+  int right = t->left + CENSUS_TILE < g.cols ? t->left + CENSUS_TILE : g.cols;
+
+  for(int i = t->top; i < bottom; i++)
+    for(int j = t->left; j < right; j++){
+      int cell = i * g.cols + j;
+      if(g.data[cell].state != 1.0){
+        job->label[cell] = -1;
+        continue;
+      }
+      while(job->parent[cell] != cell)
+        cell = job->parent[cell];
+      job->label[i * g.cols + j] = cell;
+    }
+}
+
+static int floor_div(int a, int b){
+  return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+/*
+  Cell mapped by the symmetry `t` of the lattice, in the lattice
+  coordinates, returns number of symmetries
+*/
+static int census_symmetry(Mode mode, int t, int row, int col, int out[2]){
+  switch(mode){
+    case HEXAGON: {
+      int x = col - (row - (row & 1)) / 2, z = row, y = -x - z;
+      if(t >= 6){
+        int tmp = y; y = z; z = tmp;
+      }
+      for(int k = 0; k < t % 6; k++){
+        int nx = -z, ny = -x, nz = -y;
+        x = nx; y = ny; z = nz;
+      }
+      out[0] = z;
+      out[1] = x;
+      return 12;
+    }
+    case TRIGON: {
+      int x = col - 1, y = 3 * row + 1 + ((row + col) & 1);
+      if(t >= 6)
+        x = -x;
+      for(int k = 0; k < t % 6; k++){
+        int nx = (x - y) / 2, ny = (3 * x + y) / 2;
+        x = nx; y = ny;
+      }
+      out[0] = floor_div(y, 3);
+      out[1] = x + 1;
+      return 12;
+    }
+    case TETRAGON:
+    default: {
+      int r = row, c = t >= 4 ? -col : col;
+      for(int k = 0; k < t % 4; k++){
+        int tmp = r; r = c; c = -tmp;
+      }
+      out[0] = r;
+      out[1] = c;
+      return 8;
+    }
+  }
+}
+
+static int compare_u64(const void* a, const void* b){
+  uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+  return x < y ? -1 : x > y;
+}
+
+static uint64_t census_shape(CensusJob* job, int object, uint64_t* keys){
+  Grid g = job->grid;
+  int from = job->first[object], size = job->first[object + 1] - from;
+  uint64_t best = ~0ull;
+
+  int p[2];
+  int symmetries = census_symmetry(g.mode, 0, 0, 0, p);
+  for(int t = 0; t < symmetries; t++){
+    int min[2] = { INT_MAX, INT_MAX };
+    for(int i = 0; i < size; i++){
+      int cell = job->cells[from + i];
+      census_symmetry(g.mode, t, cell / g.cols, cell % g.cols, p);
+      keys[i] = (uint64_t)(uint32_t)p[0] << 32 | (uint32_t)p[1];
+      if(p[0] < min[0]) min[0] = p[0];
+      if(p[1] < min[1]) min[1] = p[1];
+    }
+    // trigon moves only by (row, col) of an even sum, orientation stays
+    if(g.mode == TRIGON && (min[0] + min[1]) & 1)
+      min[1]--;
+
+    for(int i = 0; i < size; i++){
+      int r = (int)(keys[i] >> 32) - min[0], c = (int)(uint32_t)keys[i] - min[1];
+      keys[i] = (uint64_t)r << 32 | (uint32_t)c;
+    }
+    qsort(keys, size, sizeof(uint64_t), compare_u64);
+
+    uint64_t hash = size;
+    for(int i = 0; i < size; i++)
+      hash = zobrist_mix(hash ^ keys[i]);
+    if(hash < best)
+      best = hash;
+  }
+  return best;
+}
+
+static void census_chunk(void* arg){
+  CensusChunk* c = arg;
+  CensusJob* job = c->job;
+  int largest = 0;
+  for(int o = c->from; o < c->to; o++)
+    if(job->first[o + 1] - job->first[o] > largest)
+      largest = job->first[o + 1] - job->first[o];
+
+  uint64_t* keys = malloc(sizeof(uint64_t) * (largest ? largest : 1));
+  for(int o = c->from; o < c->to; o++)
+    job->hashes[o] = census_shape(job, o, keys);
+  free(keys);
+}
+
+typedef struct{
+  uint64_t hash;
+  int object;
+} CensusShape;
+
+static int compare_shape(const void* a, const void* b){
+  const CensusShape* x = a;
+  const CensusShape* y = b;
+  return x->hash < y->hash ? -1 : x->hash > y->hash ? 1 : x->object - y->object;
+}
+
+/*
+  Most common shapes first, then the smaller ones
+*/
+int census_compare(const void* a, const void* b){
+  const CensusEntry* x = a;
+  const CensusEntry* y = b;
+  if(x->count != y->count)
+    return y->count > x->count ? 1 : -1;
+  return x->cells - y->cells;
+}
+
+/*
+  Without a pool (census of a small grid on a worker already) tasks
+  run right away
+*/
+static void census_push(Pool* pool, void (*fn)(void* arg), void* arg){
+  if(pool)
+    pool_push(pool, fn, arg);
+  else
+    fn(arg);
+}
+
+static void census_wait(Pool* pool){
+  if(pool)
+    pool_wait(pool);
+}
+
+int census_run(Grid g, Pool* pool, Census* out){
+  int n = g.rows * g.cols;
+  CensusJob job = {
+    .grid = g,
+    .parent = malloc(sizeof(int) * n),
+    .label = malloc(sizeof(int) * n),
+    .cells = malloc(sizeof(int) * n)
+  };
+
+  // only neighbors before the cell, every pair is joined once
+  int steps[2][12][2], degree[2];
+  neighbors_steps(g.mode, steps, degree);
+  for(int k = 0; k < 2; k++){
+    job.degree[k] = 0;
+    for(int i = 0; i < degree[k]; i++)
+      if(steps[k][i][0] < 0 || (steps[k][i][0] == 0 && steps[k][i][1] < 0)){
+        job.steps[k][job.degree[k]][0] = steps[k][i][0];
+        job.steps[k][job.degree[k]][1] = steps[k][i][1];
+        job.degree[k]++;
+      }
+  }
+
+  int rows = (g.rows + CENSUS_TILE - 1) / CENSUS_TILE;
+  int cols = (g.cols + CENSUS_TILE - 1) / CENSUS_TILE;
+  CensusTile* tiles = malloc(sizeof(CensusTile) * rows * cols);
+  for(int i = 0; i < rows; i++)
+    for(int j = 0; j < cols; j++)
+      tiles[i * cols + j] = (CensusTile){ &job, i * CENSUS_TILE, j * CENSUS_TILE };
+
+  for(int i = 0; i < rows * cols; i++)
+    census_push(pool, census_tile, &tiles[i]);
+  census_wait(pool);
+
+  census_join(&job, 0, 0, g.rows, g.cols, 1);
+
+  for(int i = 0; i < rows * cols; i++)
+    census_push(pool, census_roots, &tiles[i]);
+  census_wait(pool);
+  free(tiles);
+
+  // objects numbered by their roots, cells grouped object by object,
+  // parent of a root is its object from now on
+  int* parent = job.parent;
+  for(int i = 0; i < n; i++)
+    if(job.label[i] == i)
+      parent[i] = job.objects++;
+
+  job.first = calloc(sizeof(int), job.objects + 1);
+  for(int i = 0; i < n; i++)
+    if(job.label[i] >= 0)
+      job.first[parent[job.label[i]] + 1]++;
+  for(int o = 0; o < job.objects; o++)
+    job.first[o + 1] += job.first[o];
+  int* fill = malloc(sizeof(int) * (job.objects + 1));
+  memcpy(fill, job.first, sizeof(int) * (job.objects + 1));
+  for(int i = 0; i < n; i++)
+    if(job.label[i] >= 0)
+      job.cells[fill[parent[job.label[i]]]++] = i;
+  free(fill);
+
+  job.hashes = malloc(sizeof(uint64_t) * (job.objects + 1));
+  int chunks = (job.objects + CENSUS_CHUNK - 1) / CENSUS_CHUNK;
+  CensusChunk* tasks = malloc(sizeof(CensusChunk) * (chunks + 1));
+  for(int c = 0; c < chunks; c++){
+    int to = (c + 1) * CENSUS_CHUNK;
+    tasks[c] = (CensusChunk){ &job, c * CENSUS_CHUNK, to < job.objects ? to : job.objects };
+    census_push(pool, census_chunk, &tasks[c]);
+  }
+  census_wait(pool);
+  free(tasks);
+
+  // same shapes next to each other, one entry per shape
+  CensusShape* shapes = malloc(sizeof(CensusShape) * (job.objects + 1));
+  for(int o = 0; o < job.objects; o++)
+    shapes[o] = (CensusShape){ job.hashes[o], o };
+  qsort(shapes, job.objects, sizeof(CensusShape), compare_shape);
+
+  *out = (Census){ .objects = job.objects };
+  out->entries = malloc(sizeof(CensusEntry) * (job.objects + 1));
+  for(int o = 0; o < job.objects; o++){
+    if(o && shapes[o].hash == shapes[o - 1].hash){
+      out->entries[out->size - 1].count++;
+      continue;
+    }
+    int object = shapes[o].object, cell = job.cells[job.first[object]];
+    out->entries[out->size++] = (CensusEntry){
+      .hash = shapes[o].hash,
+      .cells = job.first[object + 1] - job.first[object],
+      .count = 1,
+      .row = cell / g.cols,
+      .col = cell % g.cols
+    };
+  }
+  qsort(out->entries, out->size, sizeof(CensusEntry), census_compare);
+
+  free(shapes);
+  free(job.hashes);
+  free(job.first);
+  free(job.parent);
+  free(job.label);
+  free(job.cells);
+  return out->size;
+}
+
+void census_destroy(Census* c){
+  free(c->entries);
+  *c = (Census){};
+}
+
+void census_print(Census* c, FILE* out){
+  fprintf(out, "%-18s %6s %8s %12s\n", "shape", "cells", "count", "first at");
+  for(int i = 0; i < c->size; i++){
+    char at[32];
+    snprintf(at, sizeof(at), "%d,%d", c->entries[i].row, c->entries[i].col);
+    fprintf(out, "%016llx   %6d %8ld %12s\n",
+      (unsigned long long)c->entries[i].hash,
+      c->entries[i].cells,
+      c->entries[i].count,
+      at);
+  }
+  fprintf(out, "%ld objects, %d shapes\n", c->objects, c->size);
+}
+
+/*
+  Headless census of a settled random soup
+
+    ./build/program census [trigon|tetragon|hexagon] [size] [generations]
+
+  soup runs until it settles into a cycle (up to period 12) or for
+  `generations` at most, on the fastest kernel for the size (tune.c)
+*/
+void census_soup(Mode mode, int size, int generations){
+  Grid grid = {};
+  grid_init(&grid, mode, size, size);
+  srand(1);
+  for(int i = 0; i < size * size; i++)
+    grid.data[i].state = rand() % 3 == 0;
+
+  Rule rule = rule_from_uor(2, 3, 3);
+  Engine e = {};
+  if(!tune_engine(&e, tune(mode, size, size, BITBOARD), grid))
+    engine_init(&e, BITBOARD, grid);
+  engine_detect(&e, 12);
+  int done = engine_run(&e, rule, generations);
+  engine_store(&e, grid);
+  printf("%d generations, %s\n", done,
+    e.cycle.period ? "settled" : "not settled yet");
+
+  Census census = {};
+  double start = now_ms();
+  census_run(grid, pool_shared(), &census);
+  double elapsed = now_ms() - start;
+  census_print(&census, stdout);
+  printf("census of %dx%d in %.1f ms\n", size, size, elapsed);
+
+  census_destroy(&census);
+  engine_destroy(&e);
+  free(grid.data);
+}
@@ -0,0 +1,138 @@
+#include "utils.h"
+
+/*
+  Counts plane - neighbor counts kept up to date instead of recounted
+
+  Every cell is a byte with its state in bit 0 and the number of alive
+  neighbors above it:
+
+      value = count << 1 | state
+
+  Counts change only when a neighbor flips, so a flip adds +2 / -2 to
+  each neighbor byte and an edit costs O(neighbors) instead of a
+  recount around the cell. Step reads one byte per cell, a 32 bit mask
+  built from the rule tells which values flip:
+
+      flip[value] = ((mask[state] >> count) & 1) != state
+
+  flips are collected over the whole grid first and applied after that,
+  so the scan always sees counts of the current generation.
+
+  Flips also keep the Zobrist hash of the states (see cycle.c).
+  Counts are also the halo of the render state for free - dead cells
+  with alive neighbors are stored as 0.5 (see counts_state()).
+  Plane has a dead border of 1 row and 2 columns (trigon reaches
+  col +- 2), flips at the edges update border counts which are never
+  read, so there are no bounds checks.
+*/
+
+static int counts_index(Counts* c, int row, int col){
+  return (row + 1) * c->stride + col + 2;
+}
+
+int counts_init(Counts* c, Mode mode, int rows, int cols){
+  *c = (Counts){ .mode = mode, .rows = rows, .cols = cols, .stride = cols + 4 };
+  c->data = calloc(sizeof(unsigned char), c->stride * (rows + 2));
+  c->flips = malloc(sizeof(int) * rows * cols);
+  neighbors_offsets(mode, c->stride, c->offsets, c->degree);
+  return 1;
+}
+
+void counts_destroy(Counts* c){
+  free(c->data);
+  free(c->flips);
+  *c = (Counts){};
+}
+
+static void counts_flip(Counts* c, int index, int row, int col){
+  int class = neighbors_class(c->mode, row, col);
+  unsigned char delta = c->data[index] & 1 ? -2 : 2;
+  c->data[index] ^= 1;
+  c->hash ^= zobrist_key(row, col);
+  for(int k = 0; k < c->degree[class]; k++)
+    c->data[index + c->offsets[class][k]] += delta;
+}
+
+void counts_set(Counts* c, int row, int col, unsigned char value){
+  int index = counts_index(c, row, col);
+  if((c->data[index] & 1) != value)
+    counts_flip(c, index, row, col);
+}
+
+/*
+  Render state of the cell: 1 - alive, 0.5 - dead next to alive, 0 - dead
+*/
+float counts_state(Counts* c, int row, int col){
+  unsigned char value = c->data[counts_index(c, row, col)];
+  return value & 1 ? 1.0 : value ? 0.5 : 0.0;
+}
+
+void counts_load(Counts* c, Grid in){
+  memset(c->data, 0, sizeof(unsigned char) * c->stride * (c->rows + 2));
+  c->hash = 0;
+  for(int i = 0; i < in.rows; i++)
+    for(int j = 0; j < in.cols; j++)
+      if(in.data[i * in.cols + j].state == 1.0)
+        counts_flip(c, counts_index(c, i, j), i, j);
+}
+
+void counts_store(Counts* c, Grid out){
+  const float states[4] = { 0.0, 1.0, 0.5, 1.0 };
+  for(int i = 0; i < out.rows; i++){
+    const unsigned char* row = c->data + counts_index(c, i, 0);
+    for(int j = 0; j < out.cols; j++)
+      out.data[i * out.cols + j].state = states[(row[j] > 1) << 1 | (row[j] & 1)];
+  }
+}
+
+void counts_step(Counts* c, Rule rule){
+  unsigned short mask[2] = { rule.birth, rule.survive };
+  uint32_t flip = 0;
+  for(int value = 0; value < 32; value++){
+    int state = value & 1;
+    flip |= (uint32_t)(((mask[state] >> (value >> 1)) & 1) != state) << value;
+  }
+
+  // no branches in the scan, every cell is written to the flips and
+  // only the flipping ones are kept
+  int size = 0;
+  for(int i = 0; i < c->rows; i++){
+    const unsigned char* row = c->data + counts_index(c, i, 0);
+    int base = counts_index(c, i, 0);
+    for(int j = 0; j < c->cols; j++){
+      c->flips[size] = base + j;
+      size += (flip >> row[j]) & 1;
+    }
+  }
+
+  Tally t = tally_empty();
+  for(int i = 0; i < size; i++){
+    int index = c->flips[i];
+    int row = index / c->stride - 1, col = index % c->stride - 2;
+    counts_flip(c, index, row, col);
+    if(c->tracking){
+      if(c->data[index] & 1){
+        t.births++;
+        box_add(&t.born, row, col);
+      } else {
+        t.deaths++;
+        box_add(&t.died, row, col);
+      }
+    }
+  }
+  c->tally = t;
+}
+
+/*
+  Box of alive cells in the rows of `within`
+*/
+Box counts_box(Counts* c, Box within){
+  Box box = box_empty();
+  for(int i = within.top > 0 ? within.top : 0; i <= within.bottom && i < c->rows; i++){
+    const unsigned char* row = c->data + counts_index(c, i, 0);
+    for(int j = 0; j < c->cols; j++)
+      if(row[j] & 1)
+        box_add(&box, i, j);
+  }
+  return box;
+}
@@ -0,0 +1,50 @@
+#include "utils.h"
+
+/*
+  Cycle detection - still lifes and short oscillators by grid hashes
+
+  Grid hash is the Zobrist hash: xor of the keys of all alive cells,
+  key is a fixed pseudo random number of the (row, col) position.
+  A flip changes the hash by a single xor, so kernels keep it up to date
+  while stepping (bitboard rows are diffed while they are in cache,
+  frontier and counts kernels xor their flip lists) and no full-grid
+  pass is needed per generation.
+
+  Hashes of the last generations are kept in a ring, generation repeating
+  the one p generations back is a cycle of period p (1 - still life,
+  empty grid as well). Hash collisions are possible in theory, with 64
+  bits they are not a concern for a few generations of history.
+*/
+
+void cycle_init(Cycle* c, int period_max){
+  if(period_max > CYCLE_HISTORY)
+    period_max = CYCLE_HISTORY;
+  *c = (Cycle){ .period_max = period_max > 0 ? period_max : 0 };
+}
+
+/*
+  History is invalid after an edit or a load
+*/
+void cycle_reset(Cycle* c){
+  c->size = 0;
+  c->period = 0;
+}
+
+/*
+  Hash of the next generation, returns period of the cycle it closes
+  (0 - no cycle found within period_max generations)
+*/
+int cycle_push(Cycle* c, uint64_t hash){
+  c->period = 0;
+  for(int p = 1; p <= c->size && p <= c->period_max; p++)
+    if(c->history[(c->head - p + CYCLE_HISTORY) % CYCLE_HISTORY] == hash){
+      c->period = p;
+      break;
+    }
+
+  c->history[c->head] = hash;
+  c->head = (c->head + 1) % CYCLE_HISTORY;
+  if(c->size < CYCLE_HISTORY)
+    c->size++;
+  return c->period;
+}
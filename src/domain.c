@@ -0,0 +1,407 @@
+#define _DEFAULT_SOURCE
+#include "utils.h"
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+/*
+  Domain decomposition - one grid stepped by several processes
+
+  Grid is cut into strips of full rows, strip of rank r holds rows
+  [rows * r / ranks, rows * (r + 1) / ranks) in its own bitboard. Every
+  neighborhood reaches one row up and down at most (trigon reaches two
+  columns, but within the rows), so the halo of a strip is the last row
+  of the strip above and the first one of the strip below. They go into
+  the zero border rows of the bitboard, which kernels read anyway, and
+  strips at the grid edges keep them zero - the dead border.
+
+  Rows are stepped with their grid index, so hexagon row parity, trigon
+  flip parity and the draws of stochastic rules are those of the whole
+  grid, any number of ranks steps the same states as one bitboard.
+
+  Step:
+  - halos are exchanged by a task on the pool - the own edge rows are
+    sent and the neighbors' ones received, both sockets non-blocking in
+    one poll loop, so two ranks sending at once never block each other
+  - meanwhile the interior rows, which need no halo, are stepped here
+  - then the two edge rows
+
+  Neighbors are connected by sockets, a chain rank 0 - 1 - .. - n - 1:
+  Unix domain socket pairs for processes forked on one machine
+  (domain_spawn()), TCP for processes on several nodes
+  (domain_connect()).
+*/
+
+#define DOMAIN_RETRIES 600   // connection attempts to the rank above,
+                             // 100 ms apart
+
+int domain_init(Domain* d, Mode mode, int rows, int cols, int rank, int ranks, int up, int down){
+  *d = (Domain){
+    .rank = rank,
+    .ranks = ranks,
+    .first = (long)rows * rank / ranks,
+    .grid_rows = rows,
+    .up = up,
+    .down = down
+  };
+  int last = (long)rows * (rank + 1) / ranks;
+  if(last - d->first < 1)
+    return 0;
+  for(int k = 0; k < 2; k++){
+    int fd = k ? down : up;
+    if(fd >= 0)
+      fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  }
+  return bitboard_init(&d->board, mode, last - d->first, cols);
+}
+
+void domain_destroy(Domain* d){
+  bitboard_destroy(&d->board);
+  if(d->up >= 0)
+    close(d->up);
+  if(d->down >= 0)
+    close(d->down);
+  *d = (Domain){ .up = -1, .down = -1 };
+}
+
+/*
+  Random soup of the grid (see random.c), rows of the strip only
+*/
+long domain_random(Domain* d, uint64_t seed, double density){
+  return bitboard_random_rows(&d->board, seed, density, 0, d->board.rows, d->first);
+}
+
+/*
+  Sends `out` to and receives `in` from each of the neighbors,
+  all the bytes of every link at once. Returns 0 if a link is broken.
+*/
+static int domain_transfer(Domain* d, const void* out[2], void* in[2], size_t bytes){
+  int fds[2] = { d->up, d->down };
+  size_t sent[2] = {}, received[2] = {};
+  for(;;){
+    struct pollfd polls[2];
+    int count = 0, links[2];
+    for(int k = 0; k < 2; k++){
+      if(fds[k] < 0 || (sent[k] == bytes && received[k] == bytes))
+        continue;
+      polls[count] = (struct pollfd){
+        .fd = fds[k],
+        .events = (sent[k] < bytes ? POLLOUT : 0) | (received[k] < bytes ? POLLIN : 0)
+      };
+      links[count++] = k;
+    }
+    if(!count)
+      return 1;
+    if(poll(polls, count, -1) < 0)
+      return 0;
+
+    for(int i = 0; i < count; i++){
+      int k = links[i];
+      if(polls[i].revents & (POLLERR | POLLNVAL))
+        return 0;
+      if(polls[i].revents & POLLOUT){
+        ssize_t n = send(fds[k], (const char*)out[k] + sent[k], bytes - sent[k], MSG_NOSIGNAL);
+        if(n < 0)
+          return 0;
+        sent[k] += n;
+      }
+      if(polls[i].revents & (POLLIN | POLLHUP)){
+        ssize_t n = recv(fds[k], (char*)in[k] + received[k], bytes - received[k], 0);
+        if(n <= 0)
+          return 0;
+        received[k] += n;
+      }
+    }
+  }
+}
+
+/*
+  Own edge rows out, halo rows in
+*/
+static void domain_exchange(void* arg){
+  Domain* d = arg;
+  Bitboard* b = &d->board;
+  const void* out[2] = { bitboard_row(b, 0), bitboard_row(b, b->rows - 1) };
+  void* in[2] = { bitboard_row(b, -1), bitboard_row(b, b->rows) };
+  if(!domain_transfer(d, out, in, sizeof(uint64_t) * b->words))
+    d->broken = 1;
+}
+
+static void domain_rows(Domain* d, int from, int to){
+  Bitboard* b = &d->board;
+  for(int i = from; i < to; i++){
+    const uint64_t* c = bitboard_row(b, i);
+    const uint64_t* window[3] = { c - b->stride, c, c + b->stride };
+    uint64_t* out = b->next + (c - b->data);
+    bitboard_step_row(b, window, out, 0, b->words, d->first + i, b->generation);
+    out[b->words - 1] &= b->tail;
+  }
+}
+
+/*
+  One generation of the strip, halos are exchanged on the pool while the
+  interior is stepped (right before it without the pool). Returns 0 if
+  a neighbor is gone.
+*/
+int domain_step(Domain* d, Pool* pool, Rule rule){
+  Bitboard* b = &d->board;
+  bitboard_rule(b, rule);
+
+  if(pool)
+    pool_push(pool, domain_exchange, d);
+  else
+    domain_exchange(d);
+  domain_rows(d, 1, b->rows - 1);
+  if(pool)
+    pool_wait(pool);
+  if(d->broken)
+    return 0;
+
+  domain_rows(d, 0, 1);
+  if(b->rows > 1)
+    domain_rows(d, b->rows - 1, b->rows);
+  b->generation++;
+
+  uint64_t* tmp = b->data;
+  b->data = b->next;
+  b->next = tmp;
+  return 1;
+}
+
+static int domain_send(int fd, const void* data, size_t bytes){
+  struct pollfd p = { .fd = fd, .events = POLLOUT };
+  for(size_t sent = 0; sent < bytes;){
+    if(poll(&p, 1, -1) < 0)
+      return 0;
+    ssize_t n = send(fd, (const char*)data + sent, bytes - sent, MSG_NOSIGNAL);
+    if(n < 0)
+      return 0;
+    sent += n;
+  }
+  return 1;
+}
+
+static int domain_receive(int fd, void* data, size_t bytes){
+  struct pollfd p = { .fd = fd, .events = POLLIN };
+  for(size_t received = 0; received < bytes;){
+    if(poll(&p, 1, -1) < 0)
+      return 0;
+    ssize_t n = recv(fd, (char*)data + received, bytes - received, 0);
+    if(n <= 0)
+      return 0;
+    received += n;
+  }
+  return 1;
+}
+
+/*
+  Sum of the values of all ranks, collected up the chain: the total at
+  rank 0, partial sums at the others
+*/
+long domain_sum(Domain* d, long value){
+  long below = 0;
+  if(d->down >= 0 && domain_receive(d->down, &below, sizeof(below)))
+    value += below;
+  if(d->up >= 0 && !domain_send(d->up, &value, sizeof(value)))
+    d->broken = 1;
+  return value;
+}
+
+long domain_population(Domain* d){
+  Bitboard* b = &d->board;
+  long population = 0;
+  for(int i = 0; i < b->rows; i++){
+    const uint64_t* row = bitboard_row(b, i);
+    for(int w = 0; w < b->words; w++)
+      population += popcount(row[w]);
+  }
+  return population;
+}
+
+/*
+  Forks ranks - 1 processes, chained by Unix domain socket pairs.
+  Returns the rank of the calling process (0 - the one which called it),
+  -1 if it fails. Threads are not forked, call it before the shared pool
+  is started.
+*/
+int domain_spawn(int ranks, int* up, int* down){
+  *up = *down = -1;
+  // pair r links rank r (end 0) and rank r + 1 (end 1)
+  int (*pairs)[2] = calloc(sizeof(int[2]), ranks);
+  for(int r = 0; r + 1 < ranks; r++)
+    if(socketpair(AF_UNIX, SOCK_STREAM, 0, pairs[r]) < 0){
+      perror("Failed to create a socket pair");
+      free(pairs);
+      return -1;
+    }
+
+  fflush(NULL);   // or buffered output is written by every process
+  int rank = 0;
+  for(int r = 1; r < ranks && !rank; r++){
+    pid_t pid = fork();
+    if(pid < 0){
+      perror("Failed to fork a rank");
+      break;
+    }
+    if(!pid)
+      rank = r;
+  }
+
+  for(int r = 0; r + 1 < ranks; r++){
+    if(r == rank)
+      *down = pairs[r][0];
+    else
+      close(pairs[r][0]);
+    if(r + 1 == rank)
+      *up = pairs[r][1];
+    else
+      close(pairs[r][1]);
+  }
+  free(pairs);
+  return rank;
+}
+
+/*
+  Ranks forked by domain_spawn() exit, rank 0 waits for them
+*/
+void domain_join(int rank){
+  if(rank){
+    fflush(NULL);
+    _exit(0);
+  }
+  while(wait(NULL) > 0);
+}
+
+/*
+  Chain over TCP, `nodes` - host:port of every rank, comma separated.
+  Rank listens on its port for the rank below and connects to the rank
+  above, retried until that one listens. Returns number of ranks, 0 if
+  it fails.
+*/
+int domain_connect(const char* nodes, int rank, int* up, int* down){
+  char list[1024];
+  char* hosts[64];
+  char* ports[64];
+  int ranks = 0;
+  snprintf(list, sizeof(list), "%s", nodes);
+  for(char* node = strtok(list, ","); node && ranks < 64; node = strtok(NULL, ",")){
+    char* colon = strrchr(node, ':');
+    if(!colon)
+      return 0;
+    *colon = '\0';
+    hosts[ranks] = node;
+    ports[ranks++] = colon + 1;
+  }
+  if(rank < 0 || rank >= ranks)
+    return 0;
+
+  *up = *down = -1;
+  int listener = -1;
+  if(rank + 1 < ranks){
+    struct sockaddr_in address = {
+      .sin_family = AF_INET,
+      .sin_port = htons(atoi(ports[rank])),
+      .sin_addr.s_addr = htonl(INADDR_ANY)
+    };
+    int on = 1;
+    listener = socket(AF_INET, SOCK_STREAM, 0);
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if(bind(listener, (struct sockaddr*)&address, sizeof(address)) < 0 || listen(listener, 1) < 0){
+      perror("Failed to listen for the rank below");
+      close(listener);
+      return 0;
+    }
+  }
+
+  if(rank > 0){
+    struct addrinfo hints = { .ai_family = AF_INET, .ai_socktype = SOCK_STREAM };
+    struct addrinfo* found = NULL;
+    if(getaddrinfo(hosts[rank - 1], ports[rank - 1], &hints, &found) == 0){
+      for(int t = 0; t < DOMAIN_RETRIES && *up < 0; t++){
+        int fd = socket(found->ai_family, found->ai_socktype, found->ai_protocol);
+        if(connect(fd, found->ai_addr, found->ai_addrlen) == 0)
+          *up = fd;
+        else {
+          close(fd);
+          usleep(100000);
+        }
+      }
+      freeaddrinfo(found);
+    }
+  }
+  if(listener >= 0){
+    if(rank == 0 || *up >= 0)
+      *down = accept(listener, NULL, NULL);
+    close(listener);
+  }
+
+  // halo rows are small, send them right away
+  int on = 1;
+  for(int k = 0; k < 2; k++){
+    int fd = k ? *down : *up;
+    if(fd >= 0)
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+  }
+  return (rank == 0 || *up >= 0) && (rank + 1 == ranks || *down >= 0) ? ranks : 0;
+}
+
+/*
+  Headless run of a grid split between processes
+
+    ./build/program distributed [mode] [size] [generations] [ranks]
+
+  forks the ranks on this machine, or with GOL_NODES (host:port of every
+  rank) and GOL_RANK runs one rank of the TCP chain
+*/
+void domain_world(Mode mode, int size, int generations, int ranks){
+  int up, down, rank;
+  char* nodes = getenv("GOL_NODES");
+  if(nodes){
+    char* forced = getenv("GOL_RANK");
+    rank = forced ? atoi(forced) : 0;
+    ranks = domain_connect(nodes, rank, &up, &down);
+    if(!ranks){
+      fprintf(stderr, "Rank %d can not join GOL_NODES: %s\n", rank, nodes);
+      return;
+    }
+  }
+  else {
+    rank = domain_spawn(ranks, &up, &down);
+    if(rank < 0)
+      return;
+  }
+
+  Domain d = {};
+  if(!domain_init(&d, mode, size, size, rank, ranks, up, down)){
+    fprintf(stderr, "Rank %d has no rows of the grid\n", rank);
+    if(!nodes)
+      domain_join(rank);
+    return;
+  }
+  long population = domain_sum(&d, domain_random(&d, 1, 0.3));
+  if(!rank)
+    printf("%d ranks, %dx%d, population %ld\n", ranks, size, size, population);
+
+  Rule rule = rule_from_uor(2, 3, 3);
+  double start = now_ms();
+  int ok = 1;
+  for(int g = 0; g < generations && ok; g++)
+    ok = domain_step(&d, pool_shared(), rule);
+  double elapsed = now_ms() - start;
+  population = domain_sum(&d, domain_population(&d));
+  if(!ok)
+    fprintf(stderr, "Rank %d lost a neighbor\n", rank);
+  else if(!rank)
+    printf("generation %d, population %ld, %.3f ms/gen, %.1f Mcells/s\n",
+      d.board.generation, population, elapsed / generations,
+      (double)size * size * generations / elapsed / 1000.0);
+
+  domain_destroy(&d);
+  if(!nodes)
+    domain_join(rank);
+}
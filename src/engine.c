@@ -0,0 +1,639 @@
+#include "utils.h"
+
+/*
+  Engine - one of the step kernels with its own storage of the states
+
+  Grid keeps Cell instances for rendering, kernels keep states in
+  whatever layout suits them (see plane.c, bitboard.c, lut.c), so
+  the grid is only written in engine_store().
+  COUNTS kernel keeps neighbor counts as well, so it stores the 0.5 halo
+  of dead cells next to alive ones, GENERATIONS stores decaying cells as
+  their state 2, 3, .. (see generations.c), the other kernels store
+  only 0 / 1. LTL is the only one which steps rules of radius > 1
+  (see ltl.c), LENIA keeps levels 0 .. 1 and steps continuous rules
+  (see lenia.c). GRAPH steps any tiling by its adjacency (see graph.c).
+  MARGOLUS steps 2x2 blocks instead of neighborhoods, the
+  cut alternates with the generation parity (see margolus.c).
+  CELLS kernel is the reference one, it steps Cell states in place with
+  neighbors_alive().
+*/
+
+const char* kernel_name(Kernel kernel){
+  switch(kernel){
+    case PLANE: return "plane";
+    case BITBOARD: return "bitboard";
+    case LUT: return "lut";
+    case ISOTROPIC: return "isotropic";
+    case GRAPH: return "graph";
+    case BLOCKED: return "blocked";
+    case WAVEFRONT: return "wavefront";
+    case FRONTIER: return "frontier";
+    case COUNTS: return "counts";
+    case GENERATIONS: return "generations";
+    case LTL: return "ltl";
+    case LENIA: return "lenia";
+    case MARGOLUS: return "margolus";
+    case CELLS:
+    default: return "cells";
+  }
+}
+
+/*
+  Kernels stepping stochastic rules by chance, the ones with the row
+  steps of the bitboard (see bitboard_step_row()), the others step the
+  rule as if it was not stochastic
+*/
+int kernel_draws(Kernel kernel){
+  switch(kernel){
+    case BITBOARD:
+    case BLOCKED:
+    case WAVEFRONT:
+    case FRONTIER:
+    case GENERATIONS: return 1;
+    default: return 0;
+  }
+}
+
+int kernel_from_name(const char* name, Kernel* out){
+  for(Kernel k = CELLS; k <= MARGOLUS; k++)
+    if(!strcmp(name, kernel_name(k))){
+      *out = k;
+      return 1;
+    }
+  return 0;
+}
+
+/*
+  Mode of the headless commands by name, tetragon by default
+*/
+Mode mode_from_name(const char* name){
+  return !strcmp(name, "trigon") ? TRIGON
+    : !strcmp(name, "hexagon") ? HEXAGON : TETRAGON;
+}
+
+/*
+  Cells only with states and flip, enough for stepping without rendering
+*/
+void grid_init(Grid* g, Mode mode, int rows, int cols){
+  *g = (Grid){ .mode = mode, .rows = rows, .cols = cols };
+  g->data = calloc(sizeof(Cell), rows * cols);
+  for(int i = 0; i < rows; i++)
+    for(int j = 0; j < cols; j++)
+      g->data[i * cols + j].flip = mode == TRIGON && (i + j) % 2 ? -1.0 : 1.0;
+}
+
+/*
+  Neighbors of a cell depend on its parity class only:
+  row parity for hexagon, row + col parity for trigon (flip)
+*/
+int neighbors_class(Mode mode, int row, int col){
+  switch(mode){
+    case HEXAGON: return row & 1;
+    case TRIGON: return (row + col) & 1;
+    case TETRAGON:
+    default: return 0;
+  }
+}
+
+/*
+  Neighbor steps (drow, dcol) per parity class, probed with
+  neighbors_indices() on an inner cell of each class, so they always
+  follow the mode neighborhood
+*/
+void neighbors_steps(Mode mode, int out[2][12][2], int degree[2]){
+  Grid probe = {};
+  grid_init(&probe, mode, 6, 8);
+  degree[0] = degree[1] = 0;
+  for(int k = 0; k < 2; k++){
+    int row = 2 + (k && mode == HEXAGON);
+    int col = 2 + (k && mode == TRIGON);
+    int class = neighbors_class(mode, row, col);
+    int indices[12] = {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1};
+    neighbors_indices(row, col, probe, indices);
+
+    degree[class] = 0;   // tetragon probes class 0 twice
+    for(int i = 0; i < 12; i++)
+      if(indices[i] > -1){
+        out[class][degree[class]][0] = indices[i] / probe.cols - row;
+        out[class][degree[class]][1] = indices[i] % probe.cols - col;
+        degree[class]++;
+      }
+  }
+  free(probe.data);
+}
+
+/*
+  Neighbor offsets per parity class for a storage with the row pitch
+  `stride`
+*/
+void neighbors_offsets(Mode mode, long stride, long out[2][12], int degree[2]){
+  int steps[2][12][2];
+  neighbors_steps(mode, steps, degree);
+  for(int k = 0; k < 2; k++)
+    for(int i = 0; i < degree[k]; i++)
+      out[k][i] = steps[k][i][0] * stride + steps[k][i][1];
+}
+
+static Tally cells_step(Grid g, Rule rule){
+  unsigned char* next = calloc(sizeof(unsigned char), g.rows * g.cols);
+
+  for(int i = 0; i < g.rows; i++)
+    for(int j = 0; j < g.cols; j++){
+      char n = neighbors_alive(i, j, g);
+      unsigned short mask = g.data[i * g.cols + j].state == 1
+        ? rule.survive : rule.birth;
+      next[i * g.cols + j] = (mask >> n) & 1;
+    }
+
+  Tally t = tally_empty();
+  t.scanned = 1;
+  for(int i = 0; i < g.rows * g.cols; i++){
+    t.births += next[i] && g.data[i].state != 1;
+    t.deaths += !next[i] && g.data[i].state == 1;
+    if(next[i])
+      box_add(&t.alive, i / g.cols, i % g.cols);
+    g.data[i].state = next[i];
+  }
+  free(next);
+  return t;
+}
+
+int engine_init(Engine* e, Kernel kernel, Grid grid){
+  *e = (Engine){ .kernel = kernel, .grid = grid };
+
+  int ok = 0;
+  switch(kernel){
+    case BITBOARD:
+    case BLOCKED:
+    case WAVEFRONT: { ok = bitboard_init(&e->board, grid.mode, grid.rows, grid.cols); break; }
+    case LUT: { ok = lut_init(&e->board, grid.mode, grid.rows, grid.cols); break; }
+    case ISOTROPIC: { ok = isotropic_init(&e->board, grid.mode, grid.rows, grid.cols); break; }
+    case MARGOLUS: { ok = margolus_init(&e->board, grid.mode, grid.rows, grid.cols); break; }
+    case FRONTIER: {
+      ok = bitboard_init(&e->board, grid.mode, grid.rows, grid.cols);
+      if(ok)
+        frontier_init(&e->frontier, &e->board);
+      break;
+    }
+    case PLANE: { ok = plane_init(&e->plane, grid.mode, grid.rows, grid.cols); break; }
+    case COUNTS: { ok = counts_init(&e->counts, grid.mode, grid.rows, grid.cols); break; }
+    case LTL: { ok = ltl_init(&e->ltl, grid.mode, grid.rows, grid.cols); break; }
+    case LENIA: { ok = lenia_init(&e->lenia, grid.mode, grid.rows, grid.cols); break; }
+    case GRAPH: { ok = graph_init(&e->graph, grid.mode, grid.rows, grid.cols); break; }
+    case GENERATIONS: {
+      ok = bitboard_init(&e->board, grid.mode, grid.rows, grid.cols);
+      if(ok)
+        generations_init(&e->board);
+      break;
+    }
+    case CELLS:
+    default: return 1;
+  }
+  if(!ok)
+    return 0;
+
+  engine_load(e, grid);
+  return 1;
+}
+
+void engine_destroy(Engine* e){
+  switch(e->kernel){
+    case BITBOARD:
+    case BLOCKED:
+    case WAVEFRONT:
+    case ISOTROPIC:
+    case MARGOLUS:
+    case LUT: { bitboard_destroy(&e->board); break; }
+    case FRONTIER: {
+      bitboard_destroy(&e->board);
+      frontier_destroy(&e->frontier);
+      break;
+    }
+    case PLANE: { plane_destroy(&e->plane); break; }
+    case COUNTS: { counts_destroy(&e->counts); break; }
+    case LTL: { ltl_destroy(&e->ltl); break; }
+    case LENIA: { lenia_destroy(&e->lenia); break; }
+    case GRAPH: { graph_destroy(&e->graph); break; }
+    case GENERATIONS: {
+      generations_destroy(&e->board);
+      bitboard_destroy(&e->board);
+      break;
+    }
+    case CELLS:
+    default: break;
+  }
+  *e = (Engine){};
+}
+
+/*
+  Box of alive cells in the rows of `within`
+*/
+static Box engine_box(Engine* e, Box within){
+  switch(e->kernel){
+    case BITBOARD:
+    case BLOCKED:
+    case WAVEFRONT:
+    case FRONTIER:
+    case GENERATIONS:
+    case ISOTROPIC:
+    case MARGOLUS:
+    case LUT: return bitboard_box(&e->board, within);
+    case COUNTS: return counts_box(&e->counts, within);
+    case LTL: return ltl_box(&e->ltl, within);
+    case PLANE:
+    case CELLS:
+    default: {
+      Box box = box_empty();
+      for(int i = within.top > 0 ? within.top : 0; i <= within.bottom && i < e->grid.rows; i++)
+        for(int j = 0; j < e->grid.cols; j++)
+          if(engine_state(e, i, j) == 1.0)
+            box_add(&box, i, j);
+      return box;
+    }
+  }
+}
+
+/*
+  Stats from scratch, when tracking starts and after a load
+*/
+static Stats engine_count(Engine* e){
+  Stats s = { .generation = e->grid.generation, .box = box_empty() };
+  for(int i = 0; i < e->grid.rows; i++)
+    for(int j = 0; j < e->grid.cols; j++)
+      if(engine_state(e, i, j) == 1.0){
+        s.population++;
+        box_add(&s.box, i, j);
+      }
+  return s;
+}
+
+/*
+  Population and box after the flips, box of alive cells is exact when
+  the kernel scanned all rows, otherwise it grows by the born cells and
+  is scanned again only if a cell died on its edge
+*/
+static void engine_flips(Engine* e, Tally t, Stats* s){
+  s->population += t.births - t.deaths;
+  if(t.scanned){
+    s->box = t.alive;
+    return;
+  }
+
+  Box old = s->box;
+  box_merge(&s->box, t.born);
+  if(t.deaths && (t.died.top == old.top || t.died.bottom == old.bottom
+      || t.died.left == old.left || t.died.right == old.right))
+    s->box = engine_box(e, s->box);
+}
+
+static void engine_account(Engine* e){
+  Tally t;
+  switch(e->kernel){
+    case BITBOARD:
+    case BLOCKED:
+    case WAVEFRONT:
+    case FRONTIER:
+    case GENERATIONS:
+    case ISOTROPIC:
+    case MARGOLUS:
+    case LUT: { t = e->board.tally; break; }
+    case COUNTS: { t = e->counts.tally; break; }
+    case LTL: { t = e->ltl.tally; break; }
+    case LENIA: { t = e->lenia.tally; break; }
+    case GRAPH: { t = e->graph.tally; break; }
+    case PLANE: { t = e->plane.tally; break; }
+    case CELLS:
+    default: { t = e->tally; break; }
+  }
+
+  engine_flips(e, t, &e->stats);
+  e->stats.generation = e->grid.generation;
+  e->stats.births = t.births;
+  e->stats.deaths = t.deaths;
+  stats_push(&e->history, e->stats);
+}
+
+/*
+  Generations before an edit or a load are not part of any cycle
+*/
+static void engine_restart(Engine* e){
+  cycle_reset(&e->cycle);
+  if(e->cycle.period_max)
+    cycle_push(&e->cycle, engine_hash(e));
+}
+
+void engine_set(Engine* e, int row, int col, unsigned char value){
+  int was = engine_state(e, row, col) == 1.0;
+  switch(e->kernel){
+    case BITBOARD:
+    case BLOCKED:
+    case WAVEFRONT:
+    case ISOTROPIC:
+    case MARGOLUS:
+    case LUT: { bitboard_set(&e->board, row, col, value); break; }
+    case FRONTIER: {
+      if(bitboard_get(&e->board, row, col) != value)
+        frontier_mark(&e->frontier, &e->board, row, col);
+      bitboard_set(&e->board, row, col, value);
+      break;
+    }
+    case PLANE: { plane_set(&e->plane, row, col, value); break; }
+    case COUNTS: { counts_set(&e->counts, row, col, value); break; }
+    case LTL: { ltl_set(&e->ltl, row, col, value); break; }
+    case LENIA: { lenia_set(&e->lenia, row, col, value); break; }
+    case GRAPH: { graph_set(&e->graph, row, col, value); break; }
+    case GENERATIONS: { generations_set(&e->board, row, col, value); break; }
+    case CELLS:
+    default: { e->grid.data[row * e->grid.cols + col].state = value; break; }
+  }
+  engine_restart(e);
+
+  if(e->tracking && was != !!value){
+    Tally t = tally_empty();
+    t.births = !was;
+    t.deaths = was;
+    box_add(was ? &t.died : &t.born, row, col);
+    engine_flips(e, t, &e->stats);
+  }
+}
+
+/*
+  Render state of a single cell, to refresh cells around an edit
+  without storing the whole grid
+*/
+float engine_state(Engine* e, int row, int col){
+  switch(e->kernel){
+    case BITBOARD:
+    case BLOCKED:
+    case WAVEFRONT:
+    case FRONTIER:
+    case ISOTROPIC:
+    case MARGOLUS:
+    case LUT: return bitboard_get(&e->board, row, col);
+    case PLANE: return e->plane.data[plane_index(&e->plane, row, col)];
+    case COUNTS: return counts_state(&e->counts, row, col);
+    case LTL: return ltl_get(&e->ltl, row, col);
+    case LENIA: return lenia_get(&e->lenia, row, col);
+    case GRAPH: return graph_get(&e->graph, row, col);
+    case GENERATIONS: return generations_get(&e->board, row, col);
+    case CELLS:
+    default: return e->grid.data[row * e->grid.cols + col].state == 1.0;
+  }
+}
+
+void engine_load(Engine* e, Grid in){
+  switch(e->kernel){
+    case BITBOARD:
+    case BLOCKED:
+    case WAVEFRONT:
+    case ISOTROPIC:
+    case MARGOLUS:
+    case LUT: { bitboard_load(&e->board, in); break; }
+    case FRONTIER: {
+      bitboard_load(&e->board, in);
+      e->frontier.valid = 0;
+      break;
+    }
+    case PLANE: { plane_load(&e->plane, in); break; }
+    case COUNTS: { counts_load(&e->counts, in); break; }
+    case LTL: { ltl_load(&e->ltl, in); break; }
+    case LENIA: { lenia_load(&e->lenia, in); break; }
+    case GRAPH: { graph_load(&e->graph, in); break; }
+    case GENERATIONS: { generations_load(&e->board, in); break; }
+    case CELLS:
+    default: {
+      if(in.data != e->grid.data)
+        for(int i = 0; i < in.rows * in.cols; i++)
+          e->grid.data[i].state = in.data[i].state == 1.0;
+      break;
+    }
+  }
+  engine_restart(e);
+
+  if(e->tracking)
+    e->stats = engine_count(e);
+}
+
+/*
+  Random soup of the seed (see random.c), bitboard kernels are filled in
+  place on the pool, LENIA gets random levels, the others load it from
+  a grid
+*/
+void engine_random(Engine* e, uint64_t seed, double density, Pool* pool){
+  switch(e->kernel){
+    case BITBOARD:
+    case BLOCKED:
+    case WAVEFRONT:
+    case ISOTROPIC:
+    case MARGOLUS:
+    case LUT:
+    case FRONTIER:
+    case GENERATIONS: {
+      long population = bitboard_random(&e->board, seed, density, pool);
+      e->frontier.valid = 0;
+      if(e->kernel == GENERATIONS)
+        generations_clear(&e->board);
+      engine_restart(e);
+      if(e->tracking)
+        e->stats = (Stats){
+          .generation = e->grid.generation,
+          .population = population,
+          .box = bitboard_box(&e->board, (Box){ 0, 0, e->board.rows - 1, e->board.cols - 1 })
+        };
+      break;
+    }
+    case PLANE:
+    case COUNTS:
+    case LTL:
+    case GRAPH: {
+      Grid g = {};
+      grid_init(&g, e->grid.mode, e->grid.rows, e->grid.cols);
+      grid_random(g, seed, density);
+      engine_load(e, g);
+      free(g.data);
+      break;
+    }
+    case LENIA: {
+      lenia_random(&e->lenia, seed, density);
+      engine_restart(e);
+      if(e->tracking)
+        e->stats = engine_count(e);
+      break;
+    }
+    case CELLS:
+    default: {
+      grid_random(e->grid, seed, density);
+      engine_load(e, e->grid);
+      break;
+    }
+  }
+}
+
+void engine_store(Engine* e, Grid out){
+  switch(e->kernel){
+    case BITBOARD:
+    case BLOCKED:
+    case WAVEFRONT:
+    case FRONTIER:
+    case ISOTROPIC:
+    case MARGOLUS:
+    case LUT: { bitboard_store(&e->board, out); break; }
+    case PLANE: { plane_store(&e->plane, out); break; }
+    case COUNTS: { counts_store(&e->counts, out); break; }
+    case LTL: { ltl_store(&e->ltl, out); break; }
+    case LENIA: { lenia_store(&e->lenia, out); break; }
+    case GRAPH: { graph_store(&e->graph, out); break; }
+    case GENERATIONS: { generations_store(&e->board, out); break; }
+    case CELLS:
+    default: {
+      if(out.data != e->grid.data)
+        for(int i = 0; i < out.rows * out.cols; i++)
+          out.data[i].state = e->grid.data[i].state;
+      break;
+    }
+  }
+}
+
+void engine_step(Engine* e, Rule rule){
+  // draws of stochastic rules are keyed by the generation
+  e->board.generation = e->grid.generation;
+  switch(e->kernel){
+    case BITBOARD:
+    case BLOCKED: { bitboard_step(&e->board, rule); break; }
+    case WAVEFRONT: { wavefront_run(&e->board, pool_shared(), rule, 1); break; }
+    case LUT: { lut_step(&e->board, rule); break; }
+    case ISOTROPIC: { isotropic_step(&e->board, rule); break; }
+    case MARGOLUS: { margolus_step(&e->board, pool_shared(), rule, e->grid.generation & 1); break; }
+    case FRONTIER: { frontier_step(&e->frontier, &e->board, rule); break; }
+    case PLANE: { plane_step(&e->plane, rule); break; }
+    case COUNTS: { counts_step(&e->counts, rule); break; }
+    case LTL: { ltl_step(&e->ltl, pool_shared(), rule); break; }
+    case LENIA: { lenia_step(&e->lenia, pool_shared(), rule); break; }
+    case GRAPH: { graph_step(&e->graph, pool_shared(), rule); break; }
+    case GENERATIONS: { generations_step(&e->board, rule); break; }
+    case CELLS:
+    default: { e->tally = cells_step(e->grid, rule); break; }
+  }
+  e->grid.generation++;
+
+  if(e->tracking)
+    engine_account(e);
+
+  // a repeat means nothing when the next states are drawn
+  if(e->cycle.period_max && !rule.stochastic)
+    cycle_push(&e->cycle, engine_hash(e));
+}
+
+/*
+  Zobrist hash of the current generation, kept by the bitboard, counts,
+  ltl and graph kernels while stepping (bitboard ones only after
+  engine_detect()), Lenia hashes its levels, reference kernels hash the
+  whole grid
+*/
+uint64_t engine_hash(Engine* e){
+  switch(e->kernel){
+    case BITBOARD:
+    case BLOCKED:
+    case WAVEFRONT:
+    case FRONTIER:
+    case GENERATIONS:
+    case ISOTROPIC:
+    case LUT: return e->board.hash;
+    // the next cut is a part of the state, so the same cells on the other
+    // cut are not a repeat and periods are even
+    case MARGOLUS: return e->board.hash ^ (e->grid.generation & 1 ? zobrist_mix(~0ull) : 0);
+    case COUNTS: return e->counts.hash;
+    case LTL: return e->ltl.hash;
+    case GRAPH: return e->graph.hash;
+    case LENIA: return lenia_hash(&e->lenia);
+    case PLANE:
+    case CELLS:
+    default: {
+      uint64_t hash = 0;
+      for(int i = 0; i < e->grid.rows; i++)
+        for(int j = 0; j < e->grid.cols; j++)
+          if(engine_state(e, i, j) == 1.0)
+            hash ^= zobrist_key(i, j);
+      return hash;
+    }
+  }
+}
+
+/*
+  Cycle detection up to period_max generations, 0 - off
+*/
+void engine_detect(Engine* e, int period_max){
+  cycle_init(&e->cycle, period_max);
+  e->board.hashing = e->cycle.period_max > 0;
+  e->board.hash = e->board.hashing ? bitboard_hash(&e->board) : 0;
+  if(e->board.hashing && e->kernel == GENERATIONS)
+    e->board.hash ^= generations_hash(&e->board);
+  engine_restart(e);
+}
+
+/*
+  Statistics of every generation, the last STATS_HISTORY are kept
+*/
+void engine_track(Engine* e, int on){
+  e->tracking = on;
+  e->board.tracking = on;
+  e->counts.tracking = on;
+  e->ltl.tracking = on;
+  e->lenia.tracking = on;
+  e->graph.tracking = on;
+  e->plane.tracking = on;
+  e->history = (StatsRing){};
+  if(on){
+    e->stats = engine_count(e);
+    stats_push(&e->history, e->stats);
+  }
+}
+
+Stats engine_stats(Engine* e){
+  return e->stats;
+}
+
+/*
+  Stats of the last `max` generations, oldest first
+*/
+int engine_history(Engine* e, Stats* out, int max){
+  return stats_history(&e->history, out, max);
+}
+
+/*
+  Many generations without storing in between, BLOCKED kernel advances
+  them in one pass over the grid (see temporal.c), WAVEFRONT - as tiles
+  on the thread pool without barriers between generations (wavefront.c).
+  With cycle detection or tracking on, generations are stepped one by
+  one to check and tally each of them, the run stops at the first cycle.
+  Returns number of generations done.
+*/
+int engine_run(Engine* e, Rule rule, int generations){
+  if(e->cycle.period_max || e->tracking){
+    for(int g = 0; g < generations; g++){
+      engine_step(e, rule);
+      if(e->cycle.period)
+        return g + 1;
+    }
+    return generations;
+  }
+
+  e->board.generation = e->grid.generation;
+  switch(e->kernel){
+    case BLOCKED: {
+      bitboard_run(&e->board, rule, generations);
+      break;
+    }
+    case WAVEFRONT: {
+      wavefront_run(&e->board, pool_shared(), rule, generations);
+      break;
+    }
+    default: {
+      for(int g = 0; g < generations; g++)
+        engine_step(e, rule);
+      return generations;
+    }
+  }
+  e->grid.generation += generations;
+  return generations;
+}
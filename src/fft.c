@@ -0,0 +1,142 @@
+#include "utils.h"
+#include <math.h>
+
+/*
+  FFT - complex transform of any length, plans are built once per length
+
+  Power of two lengths are the iterative radix-2 transform, bit reversal
+  permutation and twiddles come from the plan. Other lengths (grids are
+  as big as the window allows) go through Bluestein's chirp-z:
+
+      nk = (n^2 + k^2 - (k - n)^2) / 2
+
+      X[k] = c[k] * sum x[n] c[n] * conj(c[k - n]),   c[k] = e^(-i pi k^2 / N)
+
+  so the sum is a convolution, done by a power of two plan of length
+  M >= 2N - 1 with the transform of conj(c) precomputed (and scaled by
+  1 / M of its inverse).
+
+  Transforms are forward only and unscaled, inverse is
+  conj(fft(conj(x))) / N, see fft_inverse(). Plans are read only, so
+  any number of threads can run the same plan, each with its own scratch
+  of fft_scratch() numbers.
+*/
+
+#define FFT_PI 3.14159265358979323846
+
+static Complex complex_mul(Complex a, Complex b){
+  return (Complex){ a.re * b.re - a.im * b.im, a.re * b.im + a.im * b.re };
+}
+
+static Complex complex_conj(Complex a){
+  return (Complex){ a.re, -a.im };
+}
+
+static void fft_radix2(const FftPlan* p, Complex* x){
+  for(int i = 0; i < p->n; i++)
+    if(i < p->reverse[i]){
+      Complex t = x[i];
+      x[i] = x[p->reverse[i]];
+      x[p->reverse[i]] = t;
+    }
+
+  for(int len = 2; len <= p->n; len <<= 1){
+    int half = len >> 1, step = p->n / len;
+    for(int i = 0; i < p->n; i += len)
+      for(int k = 0; k < half; k++){
+        Complex t = complex_mul(x[i + k + half], p->twiddles[k * step]);
+        Complex u = x[i + k];
+        x[i + k] = (Complex){ u.re + t.re, u.im + t.im };
+        x[i + k + half] = (Complex){ u.re - t.re, u.im - t.im };
+      }
+  }
+}
+
+void fft_plan(FftPlan* p, int n){
+  *p = (FftPlan){ .n = n };
+  if(!(n & (n - 1))){
+    p->twiddles = malloc(sizeof(Complex) * (n / 2 + 1));
+    for(int k = 0; k < n / 2; k++)
+      p->twiddles[k] = (Complex){ cos(2 * FFT_PI * k / n), -sin(2 * FFT_PI * k / n) };
+    p->reverse = malloc(sizeof(int) * n);
+    for(int i = 0, bits = __builtin_ctz(n); i < n; i++){
+      int r = 0;
+      for(int b = 0; b < bits; b++)
+        r |= ((i >> b) & 1) << (bits - 1 - b);
+      p->reverse[i] = r;
+    }
+    return;
+  }
+
+  int m = 1;
+  while(m < 2 * n - 1)
+    m <<= 1;
+  p->inner = malloc(sizeof(FftPlan));
+  fft_plan(p->inner, m);
+
+  // k^2 mod 2N keeps the chirp angle exact for long rows
+  p->chirp = malloc(sizeof(Complex) * n);
+  for(long k = 0; k < n; k++){
+    double angle = FFT_PI * (double)(k * k % (2L * n)) / n;
+    p->chirp[k] = (Complex){ cos(angle), -sin(angle) };
+  }
+
+  p->filter = calloc(sizeof(Complex), m);
+  p->filter[0] = complex_conj(p->chirp[0]);
+  for(int k = 1; k < n; k++)
+    p->filter[k] = p->filter[m - k] = complex_conj(p->chirp[k]);
+  fft_radix2(p->inner, p->filter);
+  for(int k = 0; k < m; k++)
+    p->filter[k] = (Complex){ p->filter[k].re / m, p->filter[k].im / m };
+}
+
+void fft_destroy(FftPlan* p){
+  if(p->inner){
+    fft_destroy(p->inner);
+    free(p->inner);
+  }
+  free(p->twiddles);
+  free(p->reverse);
+  free(p->chirp);
+  free(p->filter);
+  *p = (FftPlan){};
+}
+
+/*
+  Numbers of the scratch a transform of the plan takes
+*/
+int fft_scratch(const FftPlan* p){
+  return p->inner ? p->inner->n : 0;
+}
+
+void fft_forward(const FftPlan* p, Complex* x, Complex* scratch){
+  if(!p->inner){
+    fft_radix2(p, x);
+    return;
+  }
+
+  int n = p->n, m = p->inner->n;
+  for(int k = 0; k < n; k++)
+    scratch[k] = complex_mul(x[k], p->chirp[k]);
+  memset(scratch + n, 0, sizeof(Complex) * (m - n));
+  fft_radix2(p->inner, scratch);
+
+  // inverse of the product as conj(fft(conj))
+  for(int k = 0; k < m; k++)
+    scratch[k] = complex_conj(complex_mul(scratch[k], p->filter[k]));
+  fft_radix2(p->inner, scratch);
+
+  for(int k = 0; k < n; k++)
+    x[k] = complex_mul(complex_conj(scratch[k]), p->chirp[k]);
+}
+
+/*
+  Inverse without the 1 / N scale, callers fold it into their factors
+*/
+void fft_inverse(const FftPlan* p, Complex* x, Complex* scratch){
+  for(int k = 0; k < p->n; k++)
+    x[k].im = -x[k].im;
+  fft_forward(p, x, scratch);
+  for(int k = 0; k < p->n; k++)
+    x[k].im = -x[k].im;
+}
@@ -0,0 +1,165 @@
+#include "utils.h"
+
+/*
+  Frontier stepping - only cells next to a change can change
+
+  For low density runs (mostly hexagon and trigon soups which settle
+  into a few oscillators) almost every cell keeps its state, so instead
+  of the full sweep only cells changed in the last generation and their
+  neighbors are evaluated.
+
+  States stay in the bitboard. A cell is addressed by its bit position in
+  the bitboard storage, and neighbors are fixed bit offsets for each
+  parity class (see neighbors_offsets()). Border rows and words of the
+  bitboard are zero, so the offsets need no bounds checks even at the
+  grid edges.
+
+  Per generation:
+  - every changed cell and its neighbors become candidates,
+    deduplicated by the epoch stamp
+  - new states of candidates are evaluated against the current states,
+    flips are collected and applied after that
+  - when more than `threshold` cells changed, the next generation is a
+    full bitboard sweep, changes are found by xor of the two buffers,
+    and frontier stepping resumes once they are few again
+*/
+
+#define FRONTIER_DENSITY 1024  // full sweep above cells / density changes
+
+static long frontier_position(Bitboard* b, int row, int col){
+  return (long)(row + 1) * b->stride * 64 + 64 + col;
+}
+
+void frontier_init(Frontier* f, Bitboard* b){
+  *f = (Frontier){ .mode = b->mode };
+
+  neighbors_offsets(b->mode, (long)b->stride * 64, f->offsets, f->degree);
+
+  f->threshold = b->rows * b->cols / FRONTIER_DENSITY + 1;
+  f->capacity = f->threshold * 13;
+  f->changed = malloc(sizeof(long) * f->capacity);
+  f->candidates = malloc(sizeof(long) * f->capacity);
+  f->flips = malloc(sizeof(long) * f->capacity);
+  f->stamp = calloc(sizeof(unsigned int), (long)b->stride * 64 * (b->rows + 3));
+  f->valid = 0;
+}
+
+void frontier_destroy(Frontier* f){
+  free(f->changed);
+  free(f->candidates);
+  free(f->flips);
+  free(f->stamp);
+  *f = (Frontier){};
+}
+
+/*
+  Cell was edited outside of the step
+*/
+void frontier_mark(Frontier* f, Bitboard* b, int row, int col){
+  if(f->valid && f->changed_size < f->threshold)
+    f->changed[f->changed_size++] = frontier_position(b, row, col);
+  else
+    f->valid = 0;
+}
+
+static inline int bit(const uint64_t* data, long p){
+  return (data[p >> 6] >> (p & 63)) & 1;
+}
+
+static void frontier_add(Frontier* f, Bitboard* b, long p, int* size){
+  if(f->stamp[p] == f->epoch)
+    return;
+  f->stamp[p] = f->epoch;
+
+  long row = p / (b->stride * 64) - 1, col = p % (b->stride * 64) - 64;
+  if(row >= 0 && row < b->rows && col >= 0 && col < b->cols)
+    f->candidates[(*size)++] = p;
+}
+
+static void frontier_sweep(Frontier* f, Bitboard* b, Rule rule){
+  bitboard_step(b, rule);
+
+  // b->next holds the previous generation now
+  f->changed_size = 0;
+  f->valid = 1;
+  long words = (long)b->stride * (b->rows + 3);
+  for(long w = 0; w < words && f->valid; w++)
+    for(uint64_t diff = b->data[w] ^ b->next[w]; diff; diff &= diff - 1){
+      if(f->changed_size == f->threshold){
+        f->valid = 0;
+        break;
+      }
+      f->changed[f->changed_size++] = w * 64 + __builtin_ctzll(diff);
+    }
+}
+
+void frontier_step(Frontier* f, Bitboard* b, Rule rule){
+  // with another rule even unchanged neighborhoods can change
+  if(rule.birth != f->rule.birth || rule.survive != f->rule.survive){
+    f->rule = rule;
+    f->valid = 0;
+  }
+  // cells of a stochastic rule flip by chance, next to changes or not
+  if(!f->valid || rule.stochastic){
+    frontier_sweep(f, b, rule);
+    return;
+  }
+
+  if(++f->epoch == 0){   // stamps wrapped around
+    memset(f->stamp, 0, sizeof(unsigned int) * (long)b->stride * 64 * (b->rows + 3));
+    f->epoch = 1;
+  }
+
+  int size = 0;
+  for(int i = 0; i < f->changed_size; i++){
+    long p = f->changed[i];
+    long row = p / (b->stride * 64) - 1, col = p % (b->stride * 64) - 64;
+    int class = neighbors_class(f->mode, row, col);
+    frontier_add(f, b, p, &size);
+    for(int k = 0; k < f->degree[class]; k++)
+      frontier_add(f, b, p + f->offsets[class][k], &size);
+  }
+
+  unsigned short mask[2] = { rule.birth, rule.survive };
+  int flips = 0;
+  for(int i = 0; i < size; i++){
+    long p = f->candidates[i];
+    long row = p / (b->stride * 64) - 1, col = p % (b->stride * 64) - 64;
+    int class = neighbors_class(f->mode, row, col);
+
+    int n = 0;
+    for(int k = 0; k < f->degree[class]; k++)
+      n += bit(b->data, p + f->offsets[class][k]);
+    int state = bit(b->data, p);
+    if(((mask[state] >> n) & 1) != state)
+      f->flips[flips++] = p;
+  }
+
+  Tally t = tally_empty();
+  for(int i = 0; i < flips; i++){
+    uint64_t* w = b->data + (f->flips[i] >> 6);
+    uint64_t was = *w;
+    *w ^= 1ull << (f->flips[i] & 63);
+    if(b->hashing)
+      b->hash ^= zobrist_word(w - b->data, was) ^ zobrist_word(w - b->data, *w);
+    if(b->tracking){
+      long row = f->flips[i] / (b->stride * 64) - 1, col = f->flips[i] % (b->stride * 64) - 64;
+      if(*w > was){
+        t.births++;
+        box_add(&t.born, row, col);
+      } else {
+        t.deaths++;
+        box_add(&t.died, row, col);
+      }
+    }
+  }
+  b->tally = t;
+  b->generation++;
+
+  // flips become the changes of the next generation
+  long* tmp = f->changed;
+  f->changed = f->flips;
+  f->flips = tmp;
+  f->changed_size = flips;
+  f->valid = flips <= f->threshold;
+}
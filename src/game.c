@@ -2,7 +2,7 @@
 
 mat4 uProjGame;
 GLuint program_game;
-GLuint uProjectionLoc, uColorLoc, uStateLoc, uShapeLoc, uSamplerLoc;
+GLuint uProjectionLoc, uColorLoc, uStateLoc, uShapeLoc, uSamplerLoc, uStatesLoc, uLevelsLoc;
 GLuint VAO, VBO, EBO, seedVBO;
 GLuint grid_texture;
 
@@ -16,6 +16,20 @@ f32_array vertices = {};
 u8_array indices_s = {};  // solid
 u8_array indices_w = {};  // wireframe
 Grid seed = { .mode = HEXAGON, .generation = 0 };
+Engine engine = {};
+
+#define GAME_PERIOD 12   // longest cycle to pause on by default
+int settled = 0;         // period of the cycle already reported
+
+#define GAME_DENSITY 0.3 // of random soups by default
+int states = 2;          // of the Generations rule, GOL_STATES
+Rule ltl = {};           // Larger than Life rule, GOL_LTL (radius 0 - off)
+Rule lenia = {};         // continuous rule, GOL_LENIA (radius 0 - off)
+Rule blocks = {};        // Margolus block rule, GOL_BLOCKS (margolus 0 - off)
+Rule hensel = {};        // GOL_RULE in Hensel notation
+Rule chance = {};        // chances of the stochastic rule, GOL_CHANCE
+int hensel_set = 0;
+uint64_t soup = 0;       // seed of the last random soup
 
 void neighbors_indices_trigon(int row, int col, Grid in, int out[12]){
   int i = 0;
@@ -100,16 +114,16 @@ void neighbors_indices_tetragon(int row, int col, Grid in, int out[12]){
 void neighbors_indices(int row, int col, Grid in, int out[12]){
   switch (in.mode){
     case TRIGON: {
-      neighbors_indices_trigon(row, col, seed, out);
+      neighbors_indices_trigon(row, col, in, out);
       break;
     }
     case HEXAGON: {
-      neighbors_indices_hexagon(row, col, seed, out);
+      neighbors_indices_hexagon(row, col, in, out);
       break;
     }
     case TETRAGON:
     default:{
-      neighbors_indices_tetragon(row, col, seed, out);
+      neighbors_indices_tetragon(row, col, in, out);
       break;
     }
   }
@@ -158,26 +172,27 @@ char neighbors_alive_index(int index, Grid in){
   R - reproduction
 
   ( S - survival :: U <= n <= O )
-*/
-void next_generation(char u, char o, char r){
-  char** next = calloc(sizeof(char*), seed.rows);
-  for(int i=0; i< seed.rows; i++)
-    next[i] = calloc(sizeof(char), seed.cols);
-
-  for(int i = 0; i< seed.rows; i++)
-    for(int j = 0; j< seed.cols; j++){
-      char n = neighbors_alive(i, j, seed);
-      if(n < u) next[i][j] = 0;
-      if(n > o) next[i][j] = 0;
-      if(n >= u && n <= o) next[i][j] =
-        seed.data[i * seed.cols + j].state;
-      if(n == r) next[i][j] = 1;
-    }
 
-  for(int i = 0; i< seed.rows; i++)
-    for(int j = 0; j< seed.cols; j++){
-      seed.data[i * seed.cols + j].state = next[i][j];
-    }
+  Returns period of the cycle the grid has just settled into, only once,
+  so play can be resumed after the pause (0 - no new cycle)
+*/
+int next_generation(char u, char o, char r){
+  // trigon has no LTL kernel, the rule falls back to (U, O, R) there,
+  // non-totalistic rules - on all grids but squares
+  Rule rule = ltl.radius && engine.kernel == LTL ? ltl
+    : engine.kernel == LENIA ? lenia
+    : engine.kernel == MARGOLUS ? blocks
+    : hensel_set && (!hensel.isotropic || engine.kernel == ISOTROPIC || engine.kernel == LUT) ? hensel
+    : rule_from_uor(u, o, r);
+  rule.states = states;
+  if(chance.stochastic){
+    rule.stochastic = 1;
+    rule.birth_chance = chance.birth_chance;
+    rule.survive_chance = chance.survive_chance;
+    rule.seed = soup;
+  }
+  engine_step(&engine, rule);
+  engine_store(&engine, seed);
   seed.generation++;
 
   glBindBuffer(GL_ARRAY_BUFFER, seedVBO);
@@ -187,6 +202,16 @@ void next_generation(char u, char o, char r){
     sizeof(Cell) * seed.rows * seed.cols,
     seed.data);
   glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  int period = engine.cycle.period;
+  int found = period && period != settled;
+  settled = period;
+  if(found)
+    printf("Generation %d: %s, period %d\n",
+      seed.generation,
+      period == 1 ? "still life" : "oscillator",
+      period);
+  return found ? period : 0;
 }
 
 void game_init(GLuint program, Mode mode, Size size_, int width, int height){
@@ -342,6 +367,74 @@ void game_init(GLuint program, Mode mode, Size size_, int width, int height){
     }
   }
 
+  // Generations rule with GOL_STATES > 2 - dying cells decay through
+  // the states in between (see generations.c)
+  char* decay = getenv("GOL_STATES");
+  states = decay ? atoi(decay) : 2;
+  if(states < 2)
+    states = 2;
+  if(states > DECAY_STATES)
+    states = DECAY_STATES;
+
+  // Larger than Life rule with GOL_LTL - radius R neighborhoods
+  // (see ltl.c), replaces (U, O, R)
+  char* larger = getenv("GOL_LTL");
+  ltl = (Rule){};
+  if(larger && !rule_from_ltl(larger, &ltl))
+    fprintf(stderr, "Unknown GOL_LTL: %s\n", larger);
+
+  // Lenia with GOL_LENIA - levels 0 .. 1 grow by a smooth kernel
+  // convolution (see lenia.c), square grid only
+  char* continuous = getenv("GOL_LENIA");
+  lenia = (Rule){};
+  if(continuous && !rule_from_lenia(continuous, &lenia))
+    fprintf(stderr, "Unknown GOL_LENIA: %s\n", continuous);
+
+  // block rule with GOL_BLOCKS - critters / tron / billiard or the 16
+  // next blocks, 2x2 blocks of alternating cuts (see margolus.c)
+  char* block = getenv("GOL_BLOCKS");
+  blocks = (Rule){};
+  if(block && !rule_from_blocks(block, &blocks))
+    fprintf(stderr, "Unknown GOL_BLOCKS: %s\n", block);
+
+  // stochastic rule with GOL_CHANCE - births (and survivals) of the rule
+  // happen by chance, drawn by bitboard kernels (see random.c)
+  char* odds = getenv("GOL_CHANCE");
+  chance = (Rule){};
+  if(odds && !rule_chance(odds, &chance))
+    fprintf(stderr, "Unknown GOL_CHANCE: %s\n", odds);
+
+  // rule in Hensel notation with GOL_RULE, B3/S23 or isotropic
+  // non-totalistic B2-a/S12 (square grid), replaces (U, O, R)
+  char* text = getenv("GOL_RULE");
+  hensel_set = text && rule_from_hensel(text, &hensel);
+  if(text && !hensel_set)
+    fprintf(stderr, "Unknown GOL_RULE: %s\n", text);
+
+  // states for stepping live in the engine, Cell instances only render them,
+  // COUNTS keeps the halo of alive cells between generations
+  Kernel kernel = blocks.margolus ? MARGOLUS : lenia.radius ? LENIA : ltl.radius ? LTL
+    : hensel_set && hensel.isotropic ? ISOTROPIC
+    : states > 2 ? GENERATIONS : chance.stochastic ? BITBOARD : COUNTS;
+  char* forced = getenv("GOL_KERNEL");
+  if(forced && !kernel_from_name(forced, &kernel))
+    fprintf(stderr, "Unknown GOL_KERNEL: %s\n", forced);
+  if(chance.stochastic && !kernel_draws(kernel)){
+    if(forced){
+      fprintf(stderr, "GOL_KERNEL %s does not draw GOL_CHANCE, stepped by bitboard\n", forced);
+      kernel = BITBOARD;
+    }
+    else
+      fprintf(stderr, "GOL_CHANCE is ignored by the %s kernel\n", kernel_name(kernel));
+  }
+  if(!engine_init(&engine, kernel, seed))
+    engine_init(&engine, COUNTS, seed);
+
+  // play is paused once the grid repeats itself within GOL_PERIOD
+  // generations, 0 turns it off, as does a stochastic rule
+  char* period = getenv("GOL_PERIOD");
+  engine_detect(&engine, chance.stochastic ? 0 : period ? atoi(period) : GAME_PERIOD);
+
   glGenVertexArrays(1, &VAO);
   glGenBuffers(1, &VBO);
   glGenBuffers(1, &EBO);
@@ -414,6 +507,8 @@ void game_init(GLuint program, Mode mode, Size size_, int width, int height){
   uStateLoc = glGetUniformLocation(program_game, "uState");
   uShapeLoc = glGetUniformLocation(program_game, "uShape");
   uSamplerLoc = glGetUniformLocation(program_game, "uGridTexture");
+  uStatesLoc = glGetUniformLocation(program_game, "uStates");
+  uLevelsLoc = glGetUniformLocation(program_game, "uLevels");
 
   grid_texture = create_grid_texture(1,1);
 }
@@ -459,28 +554,17 @@ void game_click(int x, int y, Mode* mode){
     int row = row_col[0];
     int col = row_col[1];
     
-    int indices[12] = {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1};
+    // engine keeps the counts, only the cell and its neighbors change
+    Cell* cell = &seed.data[row * seed.cols + col];
+    engine_set(&engine, row, col, cell->state < 1.0);
+    cell->state = engine_state(&engine, row, col);
 
+    int indices[12] = {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1};
     neighbors_indices(row, col, seed, indices);
-
-    if(seed.data[row * seed.cols + col].state < 1.0){
-      seed.data[row * seed.cols + col].state = 1.0;
-      for(int i=0; i<12; i++)
-        if(indices[i] > -1 && seed.data[indices[i]].state < 1.0)
-          seed.data[indices[i]].state = 0.5;
-    } else {
-      if(!neighbors_alive(row, col, seed))
-        seed.data[row * seed.cols + col].state = 0.0;
-      else 
-        seed.data[row * seed.cols + col].state = 0.5;
-      for(int i=0; i<12; i++)
-        if(indices[i] > -1 && seed.data[indices[i]].state != 1.0){
-          if(!neighbors_alive_index(indices[i], seed))
-            seed.data[indices[i]].state = 0.0;
-          else
-            seed.data[indices[i]].state = 0.5;
-        }
-    }
+    for(int i=0; i<12; i++)
+      if(indices[i] > -1)
+        seed.data[indices[i]].state = engine_state(
+          &engine, indices[i] / seed.cols, indices[i] % seed.cols);
 
     // update VBO without reallocation as it has same size
     glBindBuffer(GL_ARRAY_BUFFER, seedVBO);
@@ -506,6 +590,8 @@ void game_render(Mode mode){
     case TRIGON:{   glUniform1f(uShapeLoc, 1.0); break; }
     case HEXAGON:{  glUniform1f(uShapeLoc, 2.0); break; }
   }
+  glUniform1f(uStatesLoc, states);
+  glUniform1f(uLevelsLoc, engine.kernel == LENIA);
 
   glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
   glClear(GL_COLOR_BUFFER_BIT);
@@ -557,8 +643,36 @@ void game_render(Mode mode){
   glDisable(GL_SCISSOR_TEST);
 }
 
+/*
+  Random soup instead of clicking the cells one by one, every call is
+  the next seed after GOL_SEED (default - 1), density is GOL_DENSITY
+*/
+void game_random(){
+  if(!soup){
+    char* forced = getenv("GOL_SEED");
+    soup = forced ? strtoull(forced, NULL, 10) : 1;
+  } else
+    soup++;
+  char* density = getenv("GOL_DENSITY");
+
+  engine_random(&engine, soup, density ? atof(density) : GAME_DENSITY, pool_shared());
+  engine_store(&engine, seed);
+  settled = 0;
+  printf("Soup %llu\n", (unsigned long long)soup);
+
+  glBindBuffer(GL_ARRAY_BUFFER, seedVBO);
+  glBufferSubData(
+    GL_ARRAY_BUFFER,
+    0,
+    sizeof(Cell) * seed.rows * seed.cols,
+    seed.data);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
 void game_destroy(){
   free(seed.data);
+  engine_destroy(&engine);
+  settled = 0;
   glDeleteVertexArrays(1, &VAO);
   glDeleteBuffers(1, &VBO);
   glDeleteBuffers(1, &EBO);
@@ -0,0 +1,225 @@
+#include "utils.h"
+
+/*
+  Generations rules - alive cells which do not survive decay through
+  states 2 .. states - 1 before they are dead again, decaying cells are
+  neither counted as neighbors nor born
+
+  States are packed into bit planes next to the bitboard:
+  - the bitboard itself is the alive (state 1) plane, so neighbors are
+    counted by the same bit-sliced row steps as for life and only alive
+    cells ever take part (see bitboard_step_row())
+  - up to DECAY_PLANES planes are a bit-sliced decay counter d, state
+    d + 1, 0 for dead and alive cells. Planes are allocated as the
+    states need them: 1 for 3 states, 2 for 4 - 5, 3 for 6 - 9
+  that is 2 - 4 bits per cell for 3 - 9 states.
+
+  Per word after the row step (`born` - what the rule gives for the
+  alive plane):
+
+      decaying = d0 | d1 | ..
+      alive'   = born & ~decaying
+      d'       = d + (decaying | alive & ~born), 0 once it is states - 1
+
+  Decay planes are updated in place, the row step reads only the alive
+  plane of the current generation. With hashing, decay words are keyed
+  as words of planes after the bitboard, so a cycle is a repeat of all
+  of the states.
+*/
+
+void generations_init(Bitboard* b){
+  b->decay_planes = 0;   // allocated by the first decaying state
+}
+
+void generations_destroy(Bitboard* b){
+  for(int p = 0; p < b->decay_planes; p++){
+    free(b->decay[p]);
+    b->decay[p] = NULL;
+  }
+  b->decay_planes = 0;
+}
+
+/*
+  Planes of the decay counter up to d (state d + 1)
+*/
+static int generations_planes(int d){
+  return d > 0 ? 32 - __builtin_clz(d) : 0;
+}
+
+/*
+  At least `planes` decay planes, new ones are all 0 - the counters of
+  the cells do not change
+*/
+static void generations_reserve(Bitboard* b, int planes){
+  long words = (long)b->stride * (b->rows + 3);
+  for(; b->decay_planes < planes; b->decay_planes++)
+    b->decay[b->decay_planes] = calloc(sizeof(uint64_t), words);
+}
+
+/*
+  Zobrist key offset of the decay plane words
+*/
+static long generations_plane(Bitboard* b, int p){
+  return (long)(p + 1) * b->stride * (b->rows + 3);
+}
+
+/*
+  All cells dead or alive (after a load or a fill of the alive plane)
+*/
+void generations_clear(Bitboard* b){
+  for(int p = 0; p < b->decay_planes; p++)
+    memset(b->decay[p], 0, sizeof(uint64_t) * b->stride * (b->rows + 3));
+}
+
+static int generations_decay(Bitboard* b, int row, int col){
+  long w = bitboard_row(b, row) - b->data + col / 64;
+  int d = 0;
+  for(int p = 0; p < b->decay_planes; p++)
+    d |= ((b->decay[p][w] >> (col % 64)) & 1) << p;
+  return d;
+}
+
+static void generations_set_decay(Bitboard* b, int row, int col, int d){
+  long w = bitboard_row(b, row) - b->data + col / 64;
+  generations_reserve(b, generations_planes(d));
+  for(int p = 0; p < b->decay_planes; p++){
+    uint64_t was = b->decay[p][w];
+    if((d >> p) & 1)
+      b->decay[p][w] |= 1ull << (col % 64);
+    else
+      b->decay[p][w] &= ~(1ull << (col % 64));
+    if(b->hashing)
+      b->hash ^= zobrist_word(generations_plane(b, p) + w, was)
+        ^ zobrist_word(generations_plane(b, p) + w, b->decay[p][w]);
+  }
+}
+
+/*
+  State of the cell, 0 - dead, 1 - alive, 2 .. - decaying
+*/
+int generations_get(Bitboard* b, int row, int col){
+  if(bitboard_get(b, row, col))
+    return 1;
+  int d = generations_decay(b, row, col);
+  return d ? d + 1 : 0;
+}
+
+void generations_set(Bitboard* b, int row, int col, int state){
+  bitboard_set(b, row, col, state == 1);
+  generations_set_decay(b, row, col, state > 1 ? state - 1 : 0);
+}
+
+void generations_load(Bitboard* b, Grid in){
+  for(int i = 0; i < in.rows; i++)
+    for(int j = 0; j < in.cols; j++){
+      float state = in.data[i * in.cols + j].state;
+      generations_set(b, i, j, state >= 1.0 && state < DECAY_STATES ? (int)state : 0);
+    }
+}
+
+void generations_store(Bitboard* b, Grid out){
+  for(int i = 0; i < out.rows; i++)
+    for(int j = 0; j < out.cols; j++)
+      out.data[i * out.cols + j].state = generations_get(b, i, j);
+}
+
+/*
+  Hash of the decay planes from scratch, bitboard_hash() of the alive
+  plane goes with it
+*/
+uint64_t generations_hash(Bitboard* b){
+  uint64_t hash = 0;
+  for(int p = 0; p < b->decay_planes; p++)
+    for(int i = 0; i < b->rows; i++){
+      long base = bitboard_row(b, i) - b->data;
+      for(int w = 0; w < b->words; w++)
+        hash ^= zobrist_word(generations_plane(b, p) + base + w, b->decay[p][base + w]);
+    }
+  return hash;
+}
+
+/*
+  Decay planes of one row after the row step, `born` is in `out`, planes
+  do not alias each other or the alive rows. With `hash` the changed
+  decay words are hashed. Inlined with constant `planes`, so the loops
+  over the planes unroll.
+*/
+static inline __attribute__((always_inline)) void generations_decay_row(
+  Bitboard* b,
+  const uint64_t* restrict c,
+  uint64_t* restrict out,
+  long base,
+  int states,
+  int planes,
+  const uint64_t last[DECAY_PLANES],
+  uint64_t* hash){
+    uint64_t* restrict d[DECAY_PLANES];
+    for(int p = 0; p < planes; p++)
+      d[p] = b->decay[p] + base;
+    for(int w = 0; w < b->words; w++){
+      uint64_t decaying = 0;
+      for(int p = 0; p < planes; p++)
+        decaying |= d[p][w];
+      uint64_t dying = c[w] & ~out[w];
+      out[w] &= ~decaying;
+
+      // ripple carry increment, cells in the last state are dead after
+      // it (with 2 states dying cells are dead right away)
+      uint64_t carry = states > 2 ? decaying | dying : decaying;
+      uint64_t end = ~0ull;
+      uint64_t next[DECAY_PLANES];
+      for(int p = 0; p < planes; p++){
+        end &= ~(d[p][w] ^ last[p]);
+        next[p] = d[p][w] ^ carry;
+        carry &= d[p][w];
+      }
+
+      if(hash && (decaying | dying))
+        for(int p = 0; p < planes; p++){
+          long key = generations_plane(b, p) + base + w;
+          *hash ^= zobrist_word(key, d[p][w]) ^ zobrist_word(key, next[p] & ~end);
+        }
+      for(int p = 0; p < planes; p++)
+        d[p][w] = next[p] & ~end;
+    }
+}
+
+void generations_step(Bitboard* b, Rule rule){
+  bitboard_rule(b, rule);
+  int states = rule.states > 2 ? rule.states : 2;
+  if(states > DECAY_STATES)
+    states = DECAY_STATES;
+  uint64_t last[DECAY_PLANES];   // decay counter of state `states - 1`
+  for(int p = 0; p < DECAY_PLANES; p++)
+    last[p] = ((states - 2) >> p) & 1 ? ~0ull : 0;
+  generations_reserve(b, generations_planes(states - 2));
+
+  Tally t = tally_empty();
+  for(int i = 0; i < b->rows; i++){
+    const uint64_t* c = bitboard_row(b, i);
+    const uint64_t* window[3] = { c - b->stride, c, c + b->stride };
+    long base = c - b->data;
+    uint64_t* out = b->next + base;
+    bitboard_step_row(b, window, out, 0, b->words, i, b->generation);
+    out[b->words - 1] &= b->tail;
+
+    // no planes - nothing decays (2 states)
+    uint64_t* hash = b->hashing ? &t.hash : NULL;
+    switch(b->decay_planes){
+      case 1: { generations_decay_row(b, c, out, base, states, 1, last, hash); break; }
+      case 2: { generations_decay_row(b, c, out, base, states, 2, last, hash); break; }
+      case 3: { generations_decay_row(b, c, out, base, states, 3, last, hash); break; }
+    }
+
+    if(b->hashing || b->tracking)
+      bitboard_tally_row(b, c, out, 0, b->words, i, &t);
+  }
+  b->hash ^= t.hash;
+  b->tally = t;
+  b->tally.scanned = 1;
+  b->generation++;
+
+  uint64_t* tmp = b->data;
+  b->data = b->next;
+  b->next = tmp;
+}
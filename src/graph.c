@@ -0,0 +1,191 @@
+#include "utils.h"
+#include "tilings.h"
+
+/*
+  Graph - any periodic tiling as a graph of cells (GRAPH kernel)
+
+  Tilings come from resources/tilings.svg: a block of tiles repeated by
+  two period steps, the preprocessor finds the tiles sharing a vertex
+  across the blocks around and writes them into tilings.h as links -
+  block offset and tile there. Grid of rows x cols tiles is cut into the
+  blocks the same way, cell (row, col) is the tile
+
+      (row % block rows) * block cols + col % block cols
+
+  of the block (row / block rows, col / block cols), so square, trigon
+  and hexagon grids of the game are the tilings "square" (1x1),
+  "triangle" (2x2) and "hexagon" (2x1), cell for cell. A new tiling is
+  only a new group in the svg.
+
+  Links of every cell are resolved once into CSR (first / adjacent),
+  links past the grid edges are dropped, so the border is dead as in the
+  other kernels. Stepping is the count of the adjacent alive cells and
+  the masks of the rule, by ranges of rows on the pool, nothing is
+  allocated after the first step.
+*/
+
+#define GRAPH_RANGES 4   // ranges per pool thread
+
+typedef struct GraphRange{
+  Graph* g;
+  unsigned short mask[2];  // next state by state, bit n - n alive neighbors
+  int from;                // rows [from, to)
+  int to;
+  Tally tally;
+} GraphRange;
+
+const Tiling* tiling_get(int index){
+  return index >= 0 && index < TILINGS ? &tilings[index] : NULL;
+}
+
+const Tiling* tiling_find(const char* name){
+  for(int i = 0; i < TILINGS; i++)
+    if(!strcmp(tilings[i].name, name))
+      return &tilings[i];
+  return NULL;
+}
+
+int graph_init(Graph* g, Mode mode, int rows, int cols){
+  const char* names[] = { [TRIGON] = "triangle", [TETRAGON] = "square", [HEXAGON] = "hexagon" };
+  const Tiling* tiling = tiling_find(names[mode]);
+  if(!tiling)
+    return 0;
+  return graph_init_tiling(g, tiling, rows, cols);
+}
+
+int graph_init_tiling(Graph* g, const Tiling* tiling, int rows, int cols){
+  *g = (Graph){ .tiling = tiling, .rows = rows, .cols = cols };
+  long cells = (long)rows * cols;
+  g->data = calloc(sizeof(unsigned char), cells);
+  g->next = calloc(sizeof(unsigned char), cells);
+  g->first = malloc(sizeof(int) * (cells + 1));
+
+  // twice: sizes first, then the neighbors
+  for(int pass = 0; pass < 2; pass++){
+    long size = 0;
+    for(int i = 0; i < rows; i++)
+      for(int j = 0; j < cols; j++){
+        int block_row = i / tiling->rows, block_col = j / tiling->cols;
+        int tile = (i % tiling->rows) * tiling->cols + j % tiling->cols;
+        if(!pass)
+          g->first[(long)i * cols + j] = size;
+        for(int k = tiling->first[tile]; k < tiling->first[tile + 1]; k++){
+          TilingLink link = tiling->links[k];
+          int row = (block_row + link.rows) * tiling->rows + link.tile / tiling->cols;
+          int col = (block_col + link.cols) * tiling->cols + link.tile % tiling->cols;
+          if(row < 0 || col < 0 || row >= rows || col >= cols)
+            continue;
+          if(pass)
+            g->adjacent[size] = row * cols + col;
+          size++;
+        }
+      }
+    if(!pass){
+      g->first[cells] = size;
+      g->adjacent = malloc(sizeof(int) * (size ? size : 1));
+    }
+  }
+  return 1;
+}
+
+void graph_destroy(Graph* g){
+  free(g->data);
+  free(g->next);
+  free(g->first);
+  free(g->adjacent);
+  free(g->ranges);
+  *g = (Graph){};
+}
+
+unsigned char graph_get(Graph* g, int row, int col){
+  return g->data[(long)row * g->cols + col];
+}
+
+void graph_set(Graph* g, int row, int col, unsigned char value){
+  unsigned char* cell = g->data + (long)row * g->cols + col;
+  if(*cell != value)
+    g->hash ^= zobrist_key(row, col);
+  *cell = value;
+}
+
+void graph_load(Graph* g, Grid in){
+  memset(g->data, 0, sizeof(unsigned char) * g->rows * g->cols);
+  g->hash = 0;
+  for(int i = 0; i < in.rows; i++)
+    for(int j = 0; j < in.cols; j++)
+      graph_set(g, i, j, in.data[i * in.cols + j].state == 1.0);
+}
+
+void graph_store(Graph* g, Grid out){
+  for(int i = 0; i < out.rows * out.cols; i++)
+    out.data[i].state = g->data[i];
+}
+
+static void graph_rows(void* arg){
+  GraphRange* r = arg;
+  Graph* g = r->g;
+  const unsigned char* data = g->data;
+  const int* first = g->first;
+  const int* adjacent = g->adjacent;
+  Tally t = tally_empty();
+  t.scanned = 1;
+
+  for(int i = r->from; i < r->to; i++){
+    long base = (long)i * g->cols;
+    for(int j = 0; j < g->cols; j++){
+      long c = base + j;
+      int n = 0;
+      for(int k = first[c]; k < first[c + 1]; k++)
+        n += data[adjacent[k]];
+      unsigned char state = data[c];
+      unsigned char next = (r->mask[state] >> n) & 1;
+      g->next[c] = next;
+
+      if(next != state){
+        t.hash ^= zobrist_key(i, j);
+        t.births += next;
+        t.deaths += state;
+      }
+      if(next && g->tracking)
+        box_add(&t.alive, i, j);
+    }
+  }
+  r->tally = t;
+}
+
+void graph_step(Graph* g, Pool* pool, Rule rule){
+  int count = pool ? pool->threads * GRAPH_RANGES : 1;
+  if(count > g->rows)
+    count = g->rows;
+  if(count > g->ranges_size){
+    free(g->ranges);
+    g->ranges = calloc(sizeof(GraphRange), count);
+    g->ranges_size = count;
+  }
+
+  for(int i = 0; i < count; i++){
+    g->ranges[i] = (GraphRange){
+      .g = g,
+      .mask = { rule.birth, rule.survive },
+      .from = (long)g->rows * i / count,
+      .to = (long)g->rows * (i + 1) / count
+    };
+    if(pool)
+      pool_push(pool, graph_rows, &g->ranges[i]);
+    else
+      graph_rows(&g->ranges[i]);
+  }
+  if(pool)
+    pool_wait(pool);
+
+  Tally t = tally_empty();
+  t.scanned = 1;
+  for(int i = 0; i < count; i++)
+    tally_merge(&t, g->ranges[i].tally);
+  g->hash ^= t.hash;
+  g->tally = t;
+
+  unsigned char* tmp = g->data;
+  g->data = g->next;
+  g->next = tmp;
+}
@@ -0,0 +1,112 @@
+#include "utils.h"
+
+/*
+  Isotropic non-totalistic rules for tetragon grid (ISOTROPIC kernel)
+
+  Next state depends on the whole 3x3 neighborhood, not only on the
+  count, so it is a 512 entry table of the bitboard built from the rule
+  (see rule_from_hensel()), rebuilt when the rule changes.
+
+  Three rows around the stepped one are interleaved into columns of 3
+  bits (above, the row, below), 8 columns at a time by the spread table:
+
+      column   j-1   j   j+1  ...
+      bits     012  345  678  ...   = key of the cell j
+
+  so the key of the cell is the low 9 bits of the rolling window, and
+  every cell costs one table load and one shift of the window by 3 bits,
+  the next 8 columns are or-ed in once per byte.
+
+  States are kept in Bitboard, so set/load/store are shared with it.
+*/
+
+static uint32_t spread[256];   // bit k of the byte goes to bit 3k
+static pthread_once_t spread_once = PTHREAD_ONCE_INIT;
+
+static void spread_build(){
+  for(int byte = 0; byte < 256; byte++){
+    spread[byte] = 0;
+    for(int k = 0; k < 8; k++)
+      spread[byte] |= (uint32_t)((byte >> k) & 1) << (3 * k);
+  }
+}
+
+static void isotropic_build(Bitboard* b, Rule rule){
+  if(!b->table)
+    b->table = malloc(512);
+  for(int key = 0; key < 512; key++){
+    // key is column by column, neighborhood of the rule - row by row
+    int neighborhood = 0;
+    for(int k = 0; k < 9; k++)
+      neighborhood |= ((key >> k) & 1) << (k % 3 * 3 + k / 3);
+    b->table[key] = rule_next(rule, neighborhood);
+  }
+
+  b->table_rule = rule;
+}
+
+int isotropic_init(Bitboard* b, Mode mode, int rows, int cols){
+  if(mode != TETRAGON)
+    return 0;
+  pthread_once(&spread_once, spread_build);
+  return bitboard_init(b, mode, rows, cols);
+}
+
+static inline unsigned int byte_of(const uint64_t* row, int k){
+  return (row[k >> 3] >> ((k & 7) * 8)) & 0xff;
+}
+
+/*
+  8 columns of the three rows from column 8k, 24 bits
+*/
+static inline uint64_t columns(const uint64_t* above, const uint64_t* row, const uint64_t* below, int k){
+  return spread[byte_of(above, k)]
+    | spread[byte_of(row, k)] << 1
+    | spread[byte_of(below, k)] << 2;
+}
+
+void isotropic_step(Bitboard* b, Rule rule){
+  if(!b->table
+    || rule.birth != b->table_rule.birth
+    || rule.survive != b->table_rule.survive
+    || rule.isotropic != b->table_rule.isotropic
+    || memcmp(rule.neighborhoods, b->table_rule.neighborhoods, sizeof(rule.neighborhoods)))
+    isotropic_build(b, rule);
+  const unsigned char* table = b->table;
+
+  Tally t = tally_empty();
+  for(int i = 0; i < b->rows; i++){
+    const uint64_t* above = bitboard_row(b, i - 1);
+    const uint64_t* row = above + b->stride;
+    const uint64_t* below = row + b->stride;
+    uint64_t* out = b->next + (row - b->data);
+
+    // column -1 is the zero border
+    uint64_t window = columns(above, row, below, 0) << 3;
+    uint64_t word = 0;
+    for(int k = 1; k <= 8 * b->words; k++){
+      window |= columns(above, row, below, k) << 27;
+      unsigned int bits = 0;
+      for(int c = 0; c < 8; c++){
+        bits |= table[window & 0x1ff] << c;
+        window >>= 3;
+      }
+      word |= (uint64_t)bits << ((k - 1) % 8 * 8);
+      if(k % 8 == 0){
+        out[k / 8 - 1] = word;
+        word = 0;
+      }
+    }
+    out[b->words - 1] &= b->tail;
+
+    if(b->hashing || b->tracking)
+      bitboard_tally_row(b, row, out, 0, b->words, i, &t);
+  }
+  b->hash ^= t.hash;
+  b->tally = t;
+  b->tally.scanned = 1;
+
+  uint64_t* tmp = b->data;
+  b->data = b->next;
+  b->next = tmp;
+}
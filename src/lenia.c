@@ -0,0 +1,274 @@
+#include "utils.h"
+#include <math.h>
+
+/*
+  Lenia - continuous states, growth by a large smooth kernel (LENIA kernel)
+
+  Every cell is a level 0 .. 1, the potential of the cell is the
+  convolution of the levels with a ring kernel of radius R (peak at R / 2,
+  normalized to sum 1) and the level grows or shrinks by it:
+
+      A' = clamp(A + dt * (2 * exp(-(U - mu)^2 / (2 sigma^2)) - 1), 0, 1)
+
+  Direct summation is O(R^2) per cell, so the convolution is a product of
+  the spectra instead, the grid wraps around (torus) as the transform
+  does. Square grid only.
+
+  Spectrum of the real levels (rows x cols) is kept as rows x (cols/2 + 1)
+  complex numbers, the other half is conjugate:
+  - rows are transformed two at a time as one complex row a + i b, then
+    split: A[k] = (Z[k] + conj(Z[-k])) / 2, B[k] = (Z[k] - conj(Z[-k])) / 2i
+  - columns - forward, times the kernel spectrum, inverse in one go
+  - rows back, two at a time again: Z = A + i B over the whole row (the
+    other half from the conjugates), real part is a, imaginary - b, and
+    the growth is applied right there
+  Every pass runs on the pool, by ranges of row pairs or columns. Plans
+  of both lengths (see fft.c) are made once, kernel spectrum - when the
+  rule changes, with the 1 / (rows * cols) of the inverse folded in.
+
+  Alive cells (for stats) are the saturated ones, level 1.
+*/
+
+#define LENIA_RANGES 4   // ranges per pool thread
+#define LENIA_QUANTA 65536   // levels per unit in the hash
+
+int lenia_init(Lenia* l, Mode mode, int rows, int cols){
+  if(mode != TETRAGON)
+    return 0;
+
+  *l = (Lenia){ .rows = rows, .cols = cols, .half = cols / 2 + 1 };
+  l->data = calloc(sizeof(float), rows * cols);
+  l->spectrum = malloc(sizeof(Complex) * rows * l->half);
+  l->kernel = malloc(sizeof(Complex) * rows * l->half);
+  fft_plan(&l->row_plan, cols);
+  fft_plan(&l->col_plan, rows);
+  return 1;
+}
+
+void lenia_destroy(Lenia* l){
+  free(l->data);
+  free(l->spectrum);
+  free(l->kernel);
+  fft_destroy(&l->row_plan);
+  fft_destroy(&l->col_plan);
+  *l = (Lenia){};
+}
+
+float lenia_get(Lenia* l, int row, int col){
+  return l->data[row * l->cols + col];
+}
+
+void lenia_set(Lenia* l, int row, int col, float value){
+  l->data[row * l->cols + col] = value < 0 ? 0 : value > 1 ? 1 : value;
+}
+
+void lenia_load(Lenia* l, Grid in){
+  for(int i = 0; i < in.rows; i++)
+    for(int j = 0; j < in.cols; j++)
+      lenia_set(l, i, j, in.data[i * in.cols + j].state);
+}
+
+void lenia_store(Lenia* l, Grid out){
+  for(int i = 0; i < out.rows * out.cols; i++)
+    out.data[i].state = l->data[i];
+}
+
+/*
+  Zobrist hash of the levels as 16 bit fixed point, so cycle detection
+  sees every change of a level and not only saturated cells
+*/
+uint64_t lenia_hash(Lenia* l){
+  uint64_t hash = 0;
+  for(long i = 0; i < (long)l->rows * l->cols; i++)
+    hash ^= zobrist_word(i, (uint64_t)(l->data[i] * LENIA_QUANTA + 0.5f));
+  return hash;
+}
+
+/*
+  Random levels in `density` of the cells, the same for the same seed
+  (see random.c)
+*/
+void lenia_random(Lenia* l, uint64_t seed, double density){
+  uint64_t threshold = density >= 1 ? UINT32_MAX : (uint64_t)(density * UINT32_MAX);
+  for(long i = 0; i < (long)l->rows * l->cols; i++){
+    uint64_t bits = counter_random(seed, i);
+    l->data[i] = (bits >> 32) < threshold ? (float)((uint32_t)bits + 1.0) / 4294967296.0 : 0;
+  }
+}
+
+typedef struct{
+  Lenia* l;
+  const float* levels;  // of the forward pass
+  Rule rule;            // of the growth
+  int multiply;         // columns are multiplied by the kernel and inverted
+  int from;             // row pairs or columns [from, to)
+  int to;
+  Tally tally;
+} LeniaRange;
+
+static void lenia_rows(void* arg){
+  LeniaRange* r = arg;
+  Lenia* l = r->l;
+  int n = l->cols;
+  Complex* z = malloc(sizeof(Complex) * (n + fft_scratch(&l->row_plan)));
+
+  for(int p = r->from; p < r->to; p++){
+    int a = 2 * p, b = 2 * p + 1;
+    const float* ra = r->levels + (long)a * n;
+    const float* rb = r->levels + (long)(b < l->rows ? b : a) * n;
+    for(int k = 0; k < n; k++)
+      z[k] = (Complex){ ra[k], b < l->rows ? rb[k] : 0 };
+    fft_forward(&l->row_plan, z, z + n);
+
+    Complex* sa = l->spectrum + (long)a * l->half;
+    Complex* sb = l->spectrum + (long)(b < l->rows ? b : a) * l->half;
+    for(int k = 0; k < l->half; k++){
+      Complex x = z[k], y = z[(n - k) % n];
+      sa[k] = (Complex){ (x.re + y.re) / 2, (x.im - y.im) / 2 };
+      if(b < l->rows)
+        sb[k] = (Complex){ (x.im + y.im) / 2, (y.re - x.re) / 2 };
+    }
+  }
+  free(z);
+}
+
+static void lenia_columns(void* arg){
+  LeniaRange* r = arg;
+  Lenia* l = r->l;
+  int n = l->rows;
+  Complex* z = malloc(sizeof(Complex) * (n + fft_scratch(&l->col_plan)));
+
+  for(int k = r->from; k < r->to; k++){
+    for(int i = 0; i < n; i++)
+      z[i] = l->spectrum[(long)i * l->half + k];
+    fft_forward(&l->col_plan, z, z + n);
+    if(r->multiply){
+      for(int i = 0; i < n; i++){
+        Complex x = z[i], y = l->kernel[(long)i * l->half + k];
+        z[i] = (Complex){ x.re * y.re - x.im * y.im, x.re * y.im + x.im * y.re };
+      }
+      fft_inverse(&l->col_plan, z, z + n);
+    }
+    for(int i = 0; i < n; i++)
+      l->spectrum[(long)i * l->half + k] = z[i];
+  }
+  free(z);
+}
+
+static void lenia_grow(void* arg){
+  LeniaRange* r = arg;
+  Lenia* l = r->l;
+  int n = l->cols;
+  Complex* z = malloc(sizeof(Complex) * (n + fft_scratch(&l->row_plan)));
+  float mu = r->rule.mu, dt = r->rule.dt;
+  float scale = -1 / (2 * r->rule.sigma * r->rule.sigma);
+  Tally t = tally_empty();
+  t.scanned = 1;
+
+  for(int p = r->from; p < r->to; p++){
+    int a = 2 * p, b = 2 * p + 1;
+    const Complex* sa = l->spectrum + (long)a * l->half;
+    const Complex* sb = l->spectrum + (long)(b < l->rows ? b : a) * l->half;
+    for(int k = 0; k < n; k++){
+      int h = k < l->half ? k : n - k;
+      Complex x = sa[h], y = b < l->rows ? sb[h] : (Complex){};
+      if(h != k){
+        x.im = -x.im;
+        y.im = -y.im;
+      }
+      z[k] = (Complex){ x.re - y.im, x.im + y.re };
+    }
+    fft_inverse(&l->row_plan, z, z + n);
+
+    for(int row = a; row <= b && row < l->rows; row++){
+      float* levels = l->data + (long)row * n;
+      for(int j = 0; j < n; j++){
+        float u = row == a ? z[j].re : z[j].im;
+        float d = u - mu;
+        float next = levels[j] + dt * (2 * expf(d * d * scale) - 1);
+        next = next < 0 ? 0 : next > 1 ? 1 : next;
+
+        int was = levels[j] == 1, now = next == 1;
+        t.births += now && !was;
+        t.deaths += was && !now;
+        if(now && l->tracking)
+          box_add(&t.alive, row, j);
+        levels[j] = next;
+      }
+    }
+  }
+  free(z);
+  r->tally = t;
+}
+
+static void lenia_pass(Lenia* l, Pool* pool, void (*fn)(void* arg), LeniaRange range, int size){
+  int count = pool ? pool->threads * LENIA_RANGES : 1;
+  if(count > size)
+    count = size;
+
+  LeniaRange* ranges = calloc(sizeof(LeniaRange), count);
+  for(int i = 0; i < count; i++){
+    ranges[i] = range;
+    ranges[i].from = (long)size * i / count;
+    ranges[i].to = (long)size * (i + 1) / count;
+    if(pool)
+      pool_push(pool, fn, &ranges[i]);
+    else
+      fn(&ranges[i]);
+  }
+  if(pool)
+    pool_wait(pool);
+
+  if(fn == lenia_grow){
+    Tally t = tally_empty();
+    t.scanned = 1;
+    for(int i = 0; i < count; i++)
+      tally_merge(&t, ranges[i].tally);
+    l->tally = t;
+  }
+  free(ranges);
+}
+
+/*
+  Spectrum of the ring kernel of the radius, wrapped around the grid
+*/
+static void lenia_kernel(Lenia* l, Pool* pool, int radius){
+  float* ring = calloc(sizeof(float), l->rows * l->cols);
+  double sum = 0;
+  for(int dy = -radius; dy <= radius; dy++)
+    for(int dx = -radius; dx <= radius; dx++){
+      double d = sqrt(dy * dy + dx * dx) / radius;
+      if(d <= 0 || d >= 1)
+        continue;
+      double k = exp(4 - 1 / (d * (1 - d)));
+      int i = ((dy % l->rows) + l->rows) % l->rows;
+      int j = ((dx % l->cols) + l->cols) % l->cols;
+      ring[i * l->cols + j] += k;
+      sum += k;
+    }
+
+  LeniaRange range = { .l = l, .levels = ring };
+  lenia_pass(l, pool, lenia_rows, range, (l->rows + 1) / 2);
+  lenia_pass(l, pool, lenia_columns, range, l->half);
+
+  double scale = 1 / (sum * l->rows * l->cols);
+  for(long i = 0; i < (long)l->rows * l->half; i++)
+    l->kernel[i] = (Complex){ l->spectrum[i].re * scale, l->spectrum[i].im * scale };
+  l->radius = radius;
+  free(ring);
+}
+
+/*
+  Rules without a growth width (the discrete ones) step the default one
+*/
+void lenia_step(Lenia* l, Pool* pool, Rule rule){
+  if(rule.sigma <= 0)
+    rule = rule_lenia_default();
+  if(rule.radius != l->radius)
+    lenia_kernel(l, pool, rule.radius);
+
+  LeniaRange range = { .l = l, .levels = l->data, .rule = rule, .multiply = 1 };
+  lenia_pass(l, pool, lenia_rows, range, (l->rows + 1) / 2);
+  lenia_pass(l, pool, lenia_columns, range, l->half);
+  lenia_pass(l, pool, lenia_grow, range, (l->rows + 1) / 2);
+}
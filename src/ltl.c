@@ -0,0 +1,347 @@
+#include "utils.h"
+
+/*
+  Larger than Life - neighborhoods of radius R (LTL kernel)
+
+  Tetragon neighborhood is the (2R + 1)^2 box around the cell, hexagon -
+  the cells within R hex steps (rings 1 .. R, 3R(R + 1) of them).
+  Counting them cell by cell is O(R^2), instead every generation builds
+  prefix sums of the states once and every count is a few lookups:
+
+  - S(y, x) - summed-area table, states in rows <= y and cols <= x
+
+        box(i, j) = S(i+R, j+R) - S(i-R-1, j+R) - S(i+R, j-R-1) + S(i-R-1, j-R-1)
+
+  - hexagon is stored in axial coordinates as in plane.c, there the
+    neighborhood is |dq| <= R, |dr| <= R, |dq + dr| <= R. Its rows above
+    the cell end at q + R and start on a diagonal, rows below start at
+    q - R and end on the other diagonal:
+
+          . . o o o            rows r-R .. r:   [q - R - dr, q + R]
+         . o o o o             rows r+1 .. r+R: [q - R, q + R - dr]
+        o o x o o
+        o o o o .
+        o o o . .
+
+    so besides S it takes D(y, x) - row prefix sums P(y', x + y - y')
+    of the rows y' <= y, along the diagonal through (y, x):
+
+        hex(r, q) = S(r, q+R) - S(r-R-1, q+R) - D(r, q-R-1) + D(r-R-1, q)
+                  + D(r+R, q) - D(r, q+R) - S(r+R, q-R-1) + S(r, q-R-1)
+
+  Lookups outside of the grid are clamped (see ltl_sum(), ltl_diagonal()),
+  sums are uint32_t, so even a wrapped one gives the right difference.
+  Step cost is the same for any radius, it is the memory passes of the
+  prefix sums plus the scan.
+
+  Every pass runs on the pool: row prefix sums by rows, columns of S by
+  column ranges, D by ranges of diagonals (each diagonal is a prefix sum
+  of its own, a range of them is a contiguous part of every row) and the
+  scan by rows.
+
+  Rule with a radius has count ranges (rule.births, rule.survivals),
+  see rule_from_ltl(), radius 0 is the usual masks over radius 1, so the
+  kernel steps every rule of the other kernels on tetragon and hexagon.
+*/
+
+#define LTL_RANGES 4    // ranges per pool thread
+
+static int ltl_index(Ltl* l, int row, int col){
+  return row * l->width + col - (row >> 1) * (l->mode == HEXAGON) + l->skew;
+}
+
+int ltl_init(Ltl* l, Mode mode, int rows, int cols){
+  if(mode == TRIGON)
+    return 0;
+
+  *l = (Ltl){ .mode = mode, .rows = rows, .cols = cols };
+  l->skew = mode == HEXAGON ? (rows - 1) >> 1 : 0;
+  l->width = cols + l->skew;
+  l->data = calloc(sizeof(unsigned char), (long)rows * l->width);
+  l->next = calloc(sizeof(unsigned char), (long)rows * l->width);
+  // S with a zero row and column in front, S(-1, x) = S(y, -1) = 0
+  l->sums = calloc(sizeof(uint32_t), (long)(rows + 1) * (l->width + 1));
+  if(mode == HEXAGON){
+    l->diagonal = calloc(sizeof(uint32_t), (long)rows * l->width);
+    l->totals = calloc(sizeof(uint32_t), rows);
+  }
+  return 1;
+}
+
+void ltl_destroy(Ltl* l){
+  free(l->data);
+  free(l->next);
+  free(l->sums);
+  free(l->diagonal);
+  free(l->totals);
+  free(l->table);
+  *l = (Ltl){};
+}
+
+unsigned char ltl_get(Ltl* l, int row, int col){
+  return l->data[ltl_index(l, row, col)];
+}
+
+void ltl_set(Ltl* l, int row, int col, unsigned char value){
+  unsigned char* cell = l->data + ltl_index(l, row, col);
+  if(*cell != value)
+    l->hash ^= zobrist_key(row, col);
+  *cell = value;
+}
+
+void ltl_load(Ltl* l, Grid in){
+  memset(l->data, 0, sizeof(unsigned char) * l->rows * l->width);
+  l->hash = 0;
+  for(int i = 0; i < in.rows; i++)
+    for(int j = 0; j < in.cols; j++)
+      ltl_set(l, i, j, in.data[i * in.cols + j].state == 1.0);
+}
+
+void ltl_store(Ltl* l, Grid out){
+  for(int i = 0; i < out.rows; i++){
+    const unsigned char* row = l->data + ltl_index(l, i, 0);
+    for(int j = 0; j < out.cols; j++)
+      out.data[i * out.cols + j].state = row[j];
+  }
+}
+
+/*
+  S(y, x), clamped - rows and cols past the grid add nothing
+*/
+static inline uint32_t ltl_sum(const Ltl* l, int y, int x){
+  y = y < -1 ? -1 : y >= l->rows ? l->rows - 1 : y;
+  x = x < -1 ? -1 : x >= l->width ? l->width - 1 : x;
+  return l->sums[(long)(y + 1) * (l->width + 1) + x + 1];
+}
+
+/*
+  D(y, x), clamped. Rows past the grid add nothing, so the diagonal
+  continues from the last row, in front of the row start the prefix
+  sums are 0, so it continues from the row where it enters the grid,
+  and after the row end they are the row totals
+*/
+static inline uint32_t ltl_diagonal(const Ltl* l, int y, int x){
+  if(y >= l->rows){
+    x += y - l->rows + 1;
+    y = l->rows - 1;
+  }
+  if(x < 0){
+    y += x;
+    x = 0;
+  }
+  if(y < 0)
+    return 0;
+  if(x >= l->width)
+    return l->totals[y];
+  return l->diagonal[(long)y * l->width + x];
+}
+
+typedef struct{
+  Ltl* l;
+  int from;             // rows, cols or diagonals [from, to)
+  int to;
+  Tally tally;
+} LtlRange;
+
+static void ltl_rows(void* arg){
+  LtlRange* r = arg;
+  Ltl* l = r->l;
+  for(int i = r->from; i < r->to; i++){
+    const unsigned char* row = l->data + (long)i * l->width;
+    uint32_t* out = l->sums + (long)(i + 1) * (l->width + 1) + 1;
+    uint32_t sum = 0;
+    for(int x = 0; x < l->width; x++)
+      out[x] = sum += row[x];
+  }
+}
+
+/*
+  D(y, x) = D(y-1, x+1) + P(y, x), rows still hold P here
+*/
+static void ltl_diagonals(void* arg){
+  LtlRange* r = arg;
+  Ltl* l = r->l;
+  for(int y = 0; y < l->rows; y++){
+    const uint32_t* p = l->sums + (long)(y + 1) * (l->width + 1) + 1;
+    uint32_t* out = l->diagonal + (long)y * l->width;
+    int from = r->from - y > 0 ? r->from - y : 0;
+    int to = r->to - y < l->width ? r->to - y : l->width;
+    if(y == 0){
+      for(int x = from; x < to; x++)
+        out[x] = p[x];
+      continue;
+    }
+    const uint32_t* above = out - l->width;
+    for(int x = from; x < to; x++)
+      out[x] = p[x] + (x + 1 < l->width ? above[x + 1] : l->totals[y - 1]);
+  }
+}
+
+static void ltl_columns(void* arg){
+  LtlRange* r = arg;
+  Ltl* l = r->l;
+  for(int y = 1; y < l->rows; y++){
+    uint32_t* out = l->sums + (long)(y + 1) * (l->width + 1) + 1;
+    const uint32_t* above = out - (l->width + 1);
+    for(int x = r->from; x < r->to; x++)
+      out[x] += above[x];
+  }
+}
+
+/*
+  Count of the cell with all the lookups clamped, for the cells next to
+  the edges
+*/
+static inline uint32_t ltl_count(const Ltl* l, int i, int q){
+  int R = l->radius;
+  if(l->mode == HEXAGON)
+    return ltl_sum(l, i, q + R) - ltl_sum(l, i - R - 1, q + R)
+      - ltl_diagonal(l, i, q - R - 1) + ltl_diagonal(l, i - R - 1, q)
+      + ltl_diagonal(l, i + R, q) - ltl_diagonal(l, i, q + R)
+      - ltl_sum(l, i + R, q - R - 1) + ltl_sum(l, i, q - R - 1);
+  return ltl_sum(l, i + R, q + R) - ltl_sum(l, i - R - 1, q + R)
+    - ltl_sum(l, i + R, q - R - 1) + ltl_sum(l, i - R - 1, q - R - 1);
+}
+
+static void ltl_scan(void* arg){
+  LtlRange* r = arg;
+  Ltl* l = r->l;
+  int R = l->radius, size = l->table_size, hexagon = l->mode == HEXAGON;
+  const unsigned char* table = l->table;
+  Tally t = tally_empty();
+  t.scanned = 1;
+
+  for(int i = r->from; i < r->to; i++){
+    int first = ltl_index(l, i, 0) - (long)i * l->width;
+    const unsigned char* row = l->data + (long)i * l->width;
+    unsigned char* out = l->next + (long)i * l->width;
+
+    // rows of all the lookups are in the grid, inner cells need no clamps
+    int inner = i > R && i + R < l->rows;
+    int from = first > R ? first : R + 1;
+    int to = first + l->cols < l->width - R ? first + l->cols : l->width - R;
+    const uint32_t *s0 = NULL, *s1 = NULL, *s2 = NULL, *d0 = NULL, *d1 = NULL, *d2 = NULL;
+    if(inner){
+      s0 = l->sums + (long)(i - R) * (l->width + 1) + 1;
+      s1 = l->sums + (long)(i + 1) * (l->width + 1) + 1;
+      s2 = l->sums + (long)(i + R + 1) * (l->width + 1) + 1;
+    }
+    if(inner && hexagon){
+      d0 = l->diagonal + (long)(i - R - 1) * l->width;
+      d1 = l->diagonal + (long)i * l->width;
+      d2 = l->diagonal + (long)(i + R) * l->width;
+    }
+
+    for(int q = first; q < first + l->cols; q++){
+      uint32_t n;
+      if(q < from || q >= to || !inner)
+        n = ltl_count(l, i, q);
+      else if(hexagon)
+        n = s1[q + R] - s0[q + R] - d1[q - R - 1] + d0[q]
+          + d2[q] - d1[q + R] - s2[q - R - 1] + s1[q - R - 1];
+      else
+        n = s2[q + R] - s0[q + R] - s2[q - R - 1] + s0[q - R - 1];
+      n -= row[q] & !l->middle;
+
+      unsigned char state = table[row[q] * size + n];
+      out[q] = state;
+      if(state != row[q]){
+        t.hash ^= zobrist_key(i, q - first);
+        if(state)
+          t.births++;
+        else
+          t.deaths++;
+      }
+      if(state && l->tracking)
+        box_add(&t.alive, i, q - first);
+    }
+  }
+  r->tally = t;
+}
+
+static void ltl_pass(Ltl* l, Pool* pool, void (*fn)(void* arg), int size){
+  int count = pool ? pool->threads * LTL_RANGES : 1;
+  if(count > size)
+    count = size;
+
+  LtlRange* ranges = calloc(sizeof(LtlRange), count);
+  for(int i = 0; i < count; i++){
+    ranges[i] = (LtlRange){
+      .l = l,
+      .from = (long)size * i / count,
+      .to = (long)size * (i + 1) / count
+    };
+    if(pool)
+      pool_push(pool, fn, &ranges[i]);
+    else
+      fn(&ranges[i]);
+  }
+  if(pool)
+    pool_wait(pool);
+
+  if(fn == ltl_scan){
+    Tally t = tally_empty();
+    t.scanned = 1;
+    for(int i = 0; i < count; i++)
+      tally_merge(&t, ranges[i].tally);
+    l->tally = t;
+  }
+  free(ranges);
+}
+
+/*
+  Next state by the state and the count, counts up to the whole
+  neighborhood with the cell itself
+*/
+static void ltl_rule(Ltl* l, Rule rule){
+  int radius = rule.radius ? rule.radius : 1;
+  int size = (l->mode == HEXAGON ? 3 * radius * (radius + 1) : 4 * radius * (radius + 1)) + 2;
+  if(size > l->table_size){
+    free(l->table);
+    l->table = malloc(sizeof(unsigned char) * 2 * size);
+  }
+  l->table_size = size;
+  l->radius = radius;
+  l->middle = rule.middle;
+
+  unsigned short mask[2] = { rule.birth, rule.survive };
+  for(int state = 0; state < 2; state++)
+    for(int n = 0; n < size; n++)
+      l->table[state * size + n] = rule.radius
+        ? state ? rule.survivals[0] <= n && n <= rule.survivals[1]
+          : rule.births[0] <= n && n <= rule.births[1]
+        : n < 16 && (mask[state] >> n) & 1;
+}
+
+void ltl_step(Ltl* l, Pool* pool, Rule rule){
+  ltl_rule(l, rule);
+
+  ltl_pass(l, pool, ltl_rows, l->rows);
+  if(l->mode == HEXAGON){
+    uint32_t total = 0;
+    for(int y = 0; y < l->rows; y++)
+      l->totals[y] = total += l->sums[(long)(y + 1) * (l->width + 1) + l->width];
+    ltl_pass(l, pool, ltl_diagonals, l->rows + l->width - 1);
+  }
+  ltl_pass(l, pool, ltl_columns, l->width);
+  ltl_pass(l, pool, ltl_scan, l->rows);
+
+  l->hash ^= l->tally.hash;
+  unsigned char* tmp = l->data;
+  l->data = l->next;
+  l->next = tmp;
+}
+
+/*
+  Box of alive cells in the rows of `within`
+*/
+Box ltl_box(Ltl* l, Box within){
+  Box box = box_empty();
+  for(int i = within.top > 0 ? within.top : 0; i <= within.bottom && i < l->rows; i++){
+    const unsigned char* row = l->data + ltl_index(l, i, 0);
+    for(int j = 0; j < l->cols; j++)
+      if(row[j])
+        box_add(&box, i, j);
+  }
+  return box;
+}
@@ -0,0 +1,113 @@
+#include "utils.h"
+
+/*
+  Lookup table kernel for tetragon grid
+
+  Grid is stepped in 2x2 blocks. Next generation of a block depends only
+  on the 4x4 neighborhood around it, which fits into 16 bit key:
+
+     key bit            block
+    0  1  2  3
+    4  5  6  7          5  6      =>  value bits  0 1
+    8  9 10 11          9 10                      2 3
+   12 13 14 15
+
+  so the whole step is 4 nibble reads, one table load and 2x2 write per
+  block. No arithmetic and no SIMD needed, only 64 KB table of the
+  bitboard which is generated for the rule and rebuilt when the rule
+  changes, so engines of different rules step side by side. Table is
+  built from the 3x3 neighborhoods (rule_next()), so isotropic
+  non-totalistic rules step here as well.
+
+  States are kept in Bitboard, so set/load/store are shared with it.
+*/
+
+static void lut_build(Bitboard* b, Rule rule){
+  static const int center[4][2] = { {1, 1}, {1, 2}, {2, 1}, {2, 2} };
+
+  if(!b->table)
+    b->table = malloc(65536);
+
+  for(int key = 0; key < 65536; key++){
+    unsigned char value = 0;
+    for(int k = 0; k < 4; k++){
+      int row = center[k][0], col = center[k][1], neighborhood = 0;
+      for(int dr = -1; dr <= 1; dr++)
+        for(int dc = -1; dc <= 1; dc++)
+          neighborhood |= ((key >> ((row + dr) * 4 + col + dc)) & 1) << ((dr + 1) * 3 + dc + 1);
+      value |= rule_next(rule, neighborhood) << k;
+    }
+    b->table[key] = value;
+  }
+
+  b->table_rule = rule;
+}
+
+int lut_init(Bitboard* b, Mode mode, int rows, int cols){
+  if(mode != TETRAGON)
+    return 0;
+  return bitboard_init(b, mode, rows, cols);
+}
+
+/*
+  4 bits of the row starting from column col - 1, block columns are
+  even so the bit offset inside the word pair is odd and both shifts
+  are in 1..63
+*/
+static inline unsigned int nibble(const uint64_t* row, int col){
+  int bit = col + 63;    // row[-1] is the zero border word
+  const uint64_t* w = row - 1 + (bit >> 6);
+  return (w[0] >> (bit & 63) | w[1] << (64 - (bit & 63))) & 0xf;
+}
+
+void lut_step(Bitboard* b, Rule rule){
+  if(!b->table
+    || rule.birth != b->table_rule.birth
+    || rule.survive != b->table_rule.survive
+    || rule.isotropic != b->table_rule.isotropic
+    || memcmp(rule.neighborhoods, b->table_rule.neighborhoods, sizeof(rule.neighborhoods)))
+    lut_build(b, rule);
+  const unsigned char* table = b->table;
+
+  Tally t = tally_empty();
+  for(int i = 0; i < b->rows; i += 2){
+    const uint64_t* r0 = bitboard_row(b, i - 1);
+    const uint64_t* r1 = r0 + b->stride;
+    const uint64_t* r2 = r1 + b->stride;
+    const uint64_t* r3 = r2 + b->stride;
+    uint64_t* out0 = b->next + (r1 - b->data);
+    uint64_t* out1 = out0 + b->stride;
+
+    for(int w = 0; w < b->words; w++){
+      uint64_t top = 0, bottom = 0;
+      for(int bit = 0; bit < 64; bit += 2){
+        int col = w * 64 + bit;
+        unsigned int key = nibble(r0, col)
+          | nibble(r1, col) << 4
+          | nibble(r2, col) << 8
+          | nibble(r3, col) << 12;
+        uint64_t value = table[key];
+        top |= (value & 3) << bit;
+        bottom |= (value >> 2) << bit;
+      }
+      out0[w] = top;
+      if(i + 1 < b->rows)
+        out1[w] = bottom;
+    }
+    out0[b->words - 1] &= b->tail;
+    if(i + 1 < b->rows)
+      out1[b->words - 1] &= b->tail;
+    if(b->hashing || b->tracking){
+      bitboard_tally_row(b, r1, out0, 0, b->words, i, &t);
+      if(i + 1 < b->rows)
+        bitboard_tally_row(b, r2, out1, 0, b->words, i + 1, &t);
+    }
+  }
+  b->hash ^= t.hash;
+  b->tally = t;
+  b->tally.scanned = 1;
+
+  uint64_t* tmp = b->data;
+  b->data = b->next;
+  b->next = tmp;
+}
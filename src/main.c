@@ -14,7 +14,87 @@ void APIENTRY debugCallback(
   printf("Debug message: %s\n", message);
 }
 
-int main() {
+int main(int argc, char** argv) {
+  // headless modes
+  if(argc > 1 && !strcmp(argv[1], "bench")){
+    bench(argc > 2 ? atoi(argv[2]) : 20);
+    return 0;
+  }
+  if(argc > 1 && !strcmp(argv[1], "census")){
+    Mode mode = mode_from_name(argc > 2 ? argv[2] : "tetragon");
+    census_soup(mode,
+      argc > 3 ? atoi(argv[3]) : 1024,
+      argc > 4 ? atoi(argv[4]) : 5000);
+    return 0;
+  }
+  if(argc > 1 && !strcmp(argv[1], "soups")){
+    Mode mode = mode_from_name(argc > 2 ? argv[2] : "tetragon");
+    // rules as u,o,r
+    Rule rules[64];
+    const char* names[64];
+    char labels[64][16];
+    int count = 0;
+    for(int i = 6; i < argc && count < 64; i++){
+      int u, o, r;
+      if(sscanf(argv[i], "%d,%d,%d", &u, &o, &r) != 3)
+        continue;
+      snprintf(labels[count], sizeof(labels[count]), "%d-%d-%d", u, o, r);
+      names[count] = labels[count];
+      rules[count++] = rule_from_uor(u, o, r);
+    }
+    if(!count){
+      names[0] = "2-3-3";
+      rules[count++] = rule_from_uor(2, 3, 3);
+    }
+    soup_search(mode,
+      argc > 3 ? atol(argv[3]) : 100000,
+      argc > 4 ? atoi(argv[4]) : 32,
+      argc > 5 ? atoi(argv[5]) : 2000,
+      rules,
+      names,
+      count);
+    return 0;
+  }
+  if(argc > 1 && !strcmp(argv[1], "mapped")){
+    Mode mode = mode_from_name(argc > 2 ? argv[2] : "tetragon");
+    mapped_world(mode,
+      argc > 3 ? atoi(argv[3]) : 65536,
+      argc > 4 ? atoi(argv[4]) : 16,
+      argc > 5 ? argv[5] : "build/world.map",
+      (argc > 6 ? atol(argv[6]) : 64) * 1024 * 1024);
+    return 0;
+  }
+  if(argc > 1 && !strcmp(argv[1], "distributed")){
+    Mode mode = mode_from_name(argc > 2 ? argv[2] : "tetragon");
+    domain_world(mode,
+      argc > 3 ? atoi(argv[3]) : 4096,
+      argc > 4 ? atoi(argv[4]) : 100,
+      argc > 5 ? atoi(argv[5]) : 4);
+    return 0;
+  }
+  if(argc > 1 && !strcmp(argv[1], "tune")){
+    Mode mode = mode_from_name(argc > 2 ? argv[2] : "tetragon");
+    tune_world(mode, argc > 3 ? atoi(argv[3]) : 1024);
+    return 0;
+  }
+  if(argc > 1 && !strcmp(argv[1], "sweep")){
+    Mode mode = mode_from_name(argc > 2 ? argv[2] : "tetragon");
+    // rules as u,o,r, all of the mode without them
+    int rules[256][3];
+    int count = 0;
+    for(int i = 7; i < argc && count < 256; i++)
+      if(sscanf(argv[i], "%d,%d,%d", &rules[count][0], &rules[count][1], &rules[count][2]) == 3)
+        count++;
+    sweep(mode,
+      argc > 3 ? atoi(argv[3]) : 128,
+      argc > 4 ? atoi(argv[4]) : 1000,
+      argc > 5 ? atoi(argv[5]) : 4,
+      argc > 6 && strcmp(argv[6], "-") ? argv[6] : NULL,
+      (const int (*)[3])rules,
+      count);
+    return 0;
+  }
+
   SDL_Window* window = NULL; 
   SDL_GLContext context = 0;
   if (!sdl_init(
@@ -58,7 +138,11 @@ int main() {
       Uint64 currentTime = SDL_GetTicks();
 
       if (currentTime - previousTime >= 1000) {
-        next_generation(2,3,3);
+        // settled into a still life or an oscillator - pause
+        if(next_generation(2,3,3)){
+          play = 0;
+          update_ui_left = 2;
+        }
         previousTime = currentTime;
       }
     }
@@ -67,6 +151,9 @@ int main() {
     while (SDL_PollEvent(&event)) {
       if (event.type == SDL_EVENT_QUIT) {
         exit = 1;
+      } else if(event.type == SDL_EVENT_KEY_DOWN && event.key.key == SDLK_R){
+        // R - random soup
+        game_random();
       } else if(event.type == SDL_EVENT_MOUSE_BUTTON_DOWN){
         int x = event.button.x;
         int y = SCREEN_HEIGHT - event.button.y; // Flip Y
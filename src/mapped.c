@@ -0,0 +1,268 @@
+#define _DEFAULT_SOURCE
+#include "utils.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+
+/*
+  Mapped world - bitboard in a memory mapped file, for grids larger
+  than the memory
+
+  File is a header page and the two planes of the bitboard (current and
+  next, the same layout as in memory), each starting on a page. Planes
+  are cut into tiles - bands of `band` full rows, so a tile is one
+  contiguous range of the file. Worlds persist: a file of the same mode
+  and size is opened at the generation it was left at.
+
+  Stepping is temporal blocking (see temporal.c), `depth` generations
+  per pass, so the file is streamed once per pass top to bottom - tile
+  after tile, the order with the most sequential reads and writes. As
+  the pass goes (bitboard stream callback):
+  - the next two tiles of the current plane are fetched (MADV_WILLNEED)
+  - tiles of it the pass is done with are dropped (MADV_DONTNEED),
+    they are clean, so it costs nothing
+  - written tiles of the next plane are scheduled for writeback and
+    dropped as well, the page cache keeps them until they are written
+
+  so only about `budget` bytes are resident whatever the size of the
+  world: a few tiles and the rings of the pass. Everything else is file
+  pages, which the kernel writes back and evicts instead of swapping.
+*/
+
+#define MAPPED_MAGIC "golmap1"
+#define MAPPED_DEPTH 8    // generations per pass at most
+
+typedef struct{
+  char magic[8];
+  int mode;
+  int rows;
+  int cols;
+  int plane;            // of the current states, 0 / 1
+  int generation;
+} MappedHeader;
+
+static size_t mapped_page(){
+  return sysconf(_SC_PAGESIZE);
+}
+
+/*
+  Hint for rows [from, to) of the plane, WILLNEED covers the pages of
+  the rows, DONTNEED only the pages within them
+*/
+static void mapped_advise(Mapped* m, uint64_t* plane, int from, int to, int advice){
+  size_t page = mapped_page();
+  uintptr_t start = (uintptr_t)(plane + (long)(from + 1) * m->board.stride);
+  uintptr_t end = (uintptr_t)(plane + (long)(to + 1) * m->board.stride);
+  if(advice == MADV_DONTNEED){
+    start = (start + page - 1) / page * page;
+    end = end / page * page;
+  }
+  else {
+    start = start / page * page;
+    end = (end + page - 1) / page * page;
+  }
+  if(end <= start)
+    return;
+  if(advice == MADV_DONTNEED)
+    msync((void*)start, end - start, MS_ASYNC);
+  madvise((void*)start, end - start, advice);
+}
+
+/*
+  Stream callback of the passes, see bitboard_run()
+*/
+static void mapped_stream(void* arg, int read, int written){
+  Mapped* m = arg;
+  Bitboard* b = &m->board;
+
+  while(m->ahead < b->rows && m->ahead < read + 2 * m->band){
+    mapped_advise(m, b->data, m->ahead, m->ahead + m->band, MADV_WILLNEED);
+    m->ahead += m->band;
+  }
+  if(read - m->read >= m->band || read >= b->rows){
+    mapped_advise(m, b->data, m->read, read, MADV_DONTNEED);
+    m->read = read;
+  }
+  if(written - m->written >= m->band || written >= b->rows){
+    mapped_advise(m, b->next, m->written, written, MADV_DONTNEED);
+    m->written = written;
+  }
+
+  // end of the pass
+  if(read >= b->rows)
+    m->ahead = m->read = m->written = 0;
+}
+
+/*
+  Opens the world in the file, or creates it with all cells dead in a
+  new or empty file. `budget` - resident bytes the stepping aims at.
+  Files which are not worlds are never touched, worlds of another mode
+  or size are replaced only with `recreate`. Returns 0 if the file can
+  not be mapped.
+*/
+int mapped_init(Mapped* m, const char* path, Mode mode, int rows, int cols, long budget, int recreate){
+  *m = (Mapped){ .fd = -1 };
+  Bitboard* b = &m->board;
+  b->mode = mode;
+  b->rows = rows;
+  b->cols = cols;
+  b->words = (cols + 63) / 64;
+  b->stride = b->words + 2;
+  b->tail = cols % 64 ? (1ull << (cols % 64)) - 1 : ~0ull;
+  b->expr.size = -1;
+
+  size_t page = mapped_page();
+  size_t plane = ((size_t)b->stride * (rows + 3) * sizeof(uint64_t) + page - 1) / page * page;
+  m->size = page + 2 * plane;
+
+  m->fd = open(path, O_RDWR | O_CREAT, 0644);
+  if(m->fd < 0){
+    perror("Failed to open the world file");
+    return 0;
+  }
+
+  struct stat st;
+  MappedHeader h = {};
+  fstat(m->fd, &st);
+  int world = st.st_size >= (off_t)sizeof(h)
+    && pread(m->fd, &h, sizeof(h), 0) == sizeof(h)
+    && !strncmp(h.magic, MAPPED_MAGIC, sizeof(h.magic));
+  if(st.st_size && !world){
+    fprintf(stderr, "%s is not a world file, left as it is\n", path);
+    close(m->fd);
+    return 0;
+  }
+  int same = world && (size_t)st.st_size == m->size
+    && h.mode == mode && h.rows == rows && h.cols == cols;
+  if(world && !same && !recreate){
+    fprintf(stderr, "%s is a world of another mode or size (%dx%d), "
+      "GOL_RECREATE=1 replaces it\n", path, h.rows, h.cols);
+    close(m->fd);
+    return 0;
+  }
+
+  // new, empty or replaced - cleared, sparse, all cells dead
+  m->fresh = !same;
+  if(m->fresh){
+    h = (MappedHeader){ .magic = MAPPED_MAGIC, .mode = mode, .rows = rows, .cols = cols };
+    if(ftruncate(m->fd, 0) || ftruncate(m->fd, m->size)
+        || pwrite(m->fd, &h, sizeof(h), 0) != sizeof(h)){
+      perror("Failed to create the world file");
+      close(m->fd);
+      return 0;
+    }
+  }
+
+  m->map = mmap(NULL, m->size, PROT_READ | PROT_WRITE, MAP_SHARED, m->fd, 0);
+  if(m->map == MAP_FAILED){
+    perror("Failed to map the world file");
+    close(m->fd);
+    m->map = NULL;
+    return 0;
+  }
+  madvise(m->map, m->size, MADV_SEQUENTIAL);
+
+  uint64_t* planes[2] = {
+    (uint64_t*)((char*)m->map + page),
+    (uint64_t*)((char*)m->map + page + plane)
+  };
+  b->data = planes[h.plane];
+  b->next = planes[!h.plane];
+  b->generation = h.generation;
+
+  // tiles: two ahead of the pass, one in it, one written, and the rings
+  long row_bytes = b->stride * sizeof(uint64_t);
+  long budget_rows = budget / row_bytes;
+  b->depth = budget_rows / 8 < MAPPED_DEPTH ? budget_rows / 8 : MAPPED_DEPTH;
+  if(b->depth < 2)
+    b->depth = 2;
+  m->band = (budget_rows - 3 * b->depth) / 4;
+  if(m->band < 1)
+    m->band = 1;
+  m->budget = budget;
+  b->stream = mapped_stream;
+  b->stream_arg = m;
+  return 1;
+}
+
+void mapped_destroy(Mapped* m){
+  if(m->map){
+    munmap(m->map, m->size);
+    close(m->fd);
+  }
+  *m = (Mapped){ .fd = -1 };
+}
+
+static void mapped_header(Mapped* m){
+  MappedHeader* h = (MappedHeader*)m->map;
+  h->plane = (char*)m->board.data > (char*)m->board.next;
+  h->generation = m->board.generation;
+  msync(m->map, mapped_page(), MS_ASYNC);
+}
+
+/*
+  Random soup (see random.c), tile by tile, returns the population
+*/
+long mapped_random(Mapped* m, uint64_t seed, double density){
+  Bitboard* b = &m->board;
+  long population = 0;
+  for(int from = 0; from < b->rows; from += m->band){
+    int to = from + m->band < b->rows ? from + m->band : b->rows;
+    population += bitboard_random_rows(b, seed, density, from, to, 0);
+    mapped_advise(m, b->data, from, to, MADV_DONTNEED);
+  }
+  return population;
+}
+
+long mapped_population(Mapped* m){
+  Bitboard* b = &m->board;
+  long population = 0;
+  for(int from = 0; from < b->rows; from += m->band){
+    int to = from + m->band < b->rows ? from + m->band : b->rows;
+    mapped_advise(m, b->data, to, to + m->band, MADV_WILLNEED);
+    for(int i = from; i < to; i++){
+      const uint64_t* row = bitboard_row(b, i);
+      for(int w = 0; w < b->words; w++)
+        population += popcount(row[w]);
+    }
+    mapped_advise(m, b->data, from, to, MADV_DONTNEED);
+  }
+  return population;
+}
+
+void mapped_run(Mapped* m, Rule rule, int generations){
+  m->ahead = m->read = m->written = 0;
+  bitboard_run(&m->board, rule, generations);
+  mapped_header(m);
+}
+
+/*
+  Headless run of a world in the file, random soup when it is new,
+  GOL_RECREATE=1 replaces a world of another mode or size
+
+    ./build/program mapped [mode] [size] [generations] [file] [budget MB]
+*/
+void mapped_world(Mode mode, int size, int generations, const char* path, long budget){
+  Mapped m = {};
+  char* recreate = getenv("GOL_RECREATE");
+  if(!mapped_init(&m, path, mode, size, size, budget, recreate && !strcmp(recreate, "1")))
+    return;
+  printf("%s world %dx%d, %.1f MB file, tiles of %d rows, %d generations per pass\n",
+    m.fresh ? "new" : "resumed", size, size, m.size / 1048576.0, m.band, m.board.depth);
+  if(m.fresh)
+    mapped_random(&m, 1, 0.3);
+
+  Rule rule = rule_from_uor(2, 3, 3);
+  double start = now_ms();
+  mapped_run(&m, rule, generations);
+  double elapsed = now_ms() - start;
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  printf("generation %d, population %ld, %.3f ms/gen, %.1f Mcells/s, peak resident %.1f MB\n",
+    m.board.generation, mapped_population(&m), elapsed / generations,
+    (double)size * size * generations / elapsed / 1000.0, usage.ru_maxrss / 1024.0);
+  mapped_destroy(&m);
+}
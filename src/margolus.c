@@ -0,0 +1,216 @@
+#include "utils.h"
+
+/*
+  Margolus block automaton - partitioning CA on the tetragon bitboard
+  (MARGOLUS kernel)
+
+  Grid is cut into 2x2 blocks, every block is replaced by the next one
+  from the 16 entry table of the rule (rule.blocks), block bits are
+
+      0 1
+      2 3
+
+  Even generations cut at (0, 0), odd ones at (1, 1), so the blocks
+  overlap across generations and things can move. Cells of the blocks
+  cut by the grid edges keep their states, so a reversible table gives
+  a reversible grid as well.
+
+  Row pair words hold 32 blocks, block bits are the even / odd lanes of
+  the two words, and the table is evaluated bit-sliced: 16 minterms of
+  the 4 lanes, each or-ed into the output bits the table sets. For the
+  odd cut the row is read shifted by one column and written back
+  shifted. Blocks do not depend on each other, so row pairs run on the
+  pool in ranges.
+*/
+
+#define MARGOLUS_RANGES 4      // ranges per pool thread
+#define EVEN 0x5555555555555555ull
+
+/*
+  Block tables - next block of each block
+*/
+static void blocks_critters(unsigned char out[16]){
+  // 2 cells - the same, else complement, and 3 cells also turn around
+  for(int b = 0; b < 16; b++){
+    int n = __builtin_popcount(b), next = n == 2 ? b : ~b & 15;
+    if(n == 3)
+      next = (next & 1) << 3 | (next & 2) << 1 | (next & 4) >> 1 | (next & 8) >> 3;
+    out[b] = next;
+  }
+}
+
+static void blocks_tron(unsigned char out[16]){
+  for(int b = 0; b < 16; b++)
+    out[b] = b == 0 || b == 15 ? 15 - b : b;
+}
+
+static void blocks_billiard(unsigned char out[16]){
+  // single balls go through, diagonal pairs bounce off each other
+  for(int b = 0; b < 16; b++)
+    out[b] = b;
+  out[1] = 8; out[8] = 1; out[2] = 4; out[4] = 2;
+  out[9] = 6; out[6] = 9;
+}
+
+/*
+  Block rule by name (critters, tron, billiard) or as 16 comma separated
+  next blocks. Returns 0 if the text is not such a rule.
+*/
+int rule_from_blocks(const char* text, Rule* out){
+  Rule rule = { .margolus = 1 };
+  if(!strcmp(text, "critters"))
+    blocks_critters(rule.blocks);
+  else if(!strcmp(text, "tron"))
+    blocks_tron(rule.blocks);
+  else if(!strcmp(text, "billiard"))
+    blocks_billiard(rule.blocks);
+  else {
+    const char* c = text;
+    for(int b = 0; b < 16; b++){
+      char* end;
+      long next = strtol(c, &end, 10);
+      if(end == c || next < 0 || next > 15 || *end != (b < 15 ? ',' : '\0'))
+        return 0;
+      rule.blocks[b] = next;
+      c = end + 1;
+    }
+  }
+  *out = rule;
+  return 1;
+}
+
+int margolus_init(Bitboard* b, Mode mode, int rows, int cols){
+  if(mode != TETRAGON)
+    return 0;
+  return bitboard_init(b, mode, rows, cols);
+}
+
+typedef struct{
+  Bitboard* b;
+  uint64_t select[16][4];  // minterm of the block goes to the output bit
+  const uint64_t* full;    // cells of the whole blocks, per word
+  int phase;
+  int from;                // row pairs [from, to)
+  int to;
+  Tally tally;
+} MargolusRange;
+
+/*
+  32 blocks, top left cells in the even lanes of `top`
+*/
+static inline void margolus_blocks(const MargolusRange* r, uint64_t* top, uint64_t* bottom){
+  uint64_t a = *top & EVEN, b = *top >> 1 & EVEN;
+  uint64_t c = *bottom & EVEN, d = *bottom >> 1 & EVEN;
+  uint64_t ab[4] = { ~a & ~b & EVEN, a & ~b, ~a & b & EVEN, a & b };
+  uint64_t cd[4] = { ~c & ~d & EVEN, c & ~d, ~c & d & EVEN, c & d };
+
+  uint64_t o[4] = {};
+  for(int m = 0; m < 16; m++){
+    uint64_t term = ab[m & 3] & cd[m >> 2];
+    for(int k = 0; k < 4; k++)
+      o[k] |= term & r->select[m][k];
+  }
+  *top = o[0] | o[1] << 1;
+  *bottom = o[2] | o[3] << 1;
+}
+
+static void margolus_rows(void* arg){
+  MargolusRange* r = arg;
+  Bitboard* b = r->b;
+  Tally t = tally_empty();
+
+  for(int p = r->from; p < r->to; p++){
+    int i = r->phase + 2 * p;
+    const uint64_t* top = bitboard_row(b, i);
+    const uint64_t* bottom = top + b->stride;
+    uint64_t* out_top = b->next + (top - b->data);
+    uint64_t* out_bottom = out_top + b->stride;
+
+    uint64_t carry_top = 0, carry_bottom = 0;
+    for(int w = 0; w < b->words; w++){
+      uint64_t x = top[w], y = bottom[w];
+      if(r->phase){
+        // the cut at column 1, top[words] is the zero border
+        x = x >> 1 | top[w + 1] << 63;
+        y = y >> 1 | bottom[w + 1] << 63;
+      }
+      margolus_blocks(r, &x, &y);
+      if(r->phase){
+        uint64_t high_top = x >> 63, high_bottom = y >> 63;
+        x = x << 1 | carry_top;
+        y = y << 1 | carry_bottom;
+        carry_top = high_top;
+        carry_bottom = high_bottom;
+      }
+      out_top[w] = (x & r->full[w]) | (top[w] & ~r->full[w]);
+      out_bottom[w] = (y & r->full[w]) | (bottom[w] & ~r->full[w]);
+    }
+
+    if(b->hashing || b->tracking){
+      bitboard_tally_row(b, top, out_top, 0, b->words, i, &t);
+      bitboard_tally_row(b, bottom, out_bottom, 0, b->words, i + 1, &t);
+    }
+  }
+  r->tally = t;
+}
+
+void margolus_step(Bitboard* b, Pool* pool, Rule rule, int phase){
+  unsigned char blocks[16];
+  if(rule.margolus)
+    memcpy(blocks, rule.blocks, sizeof(blocks));
+  else
+    blocks_critters(blocks);
+
+  // cells of the whole blocks of the cut
+  uint64_t* full = calloc(sizeof(uint64_t), b->words);
+  for(int col = phase; col + 1 < b->cols; col += 2){
+    full[col >> 6] |= 1ull << (col & 63);
+    full[(col + 1) >> 6] |= 1ull << ((col + 1) & 63);
+  }
+
+  int pairs = (b->rows - phase) / 2;
+  int count = pool ? pool->threads * MARGOLUS_RANGES : 1;
+  if(count > pairs)
+    count = pairs;
+
+  MargolusRange* ranges = calloc(sizeof(MargolusRange), count);
+  MargolusRange range = { .b = b, .full = full, .phase = phase };
+  for(int m = 0; m < 16; m++)
+    for(int k = 0; k < 4; k++)
+      range.select[m][k] = (blocks[m] >> k) & 1 ? EVEN : 0;
+  for(int i = 0; i < count; i++){
+    ranges[i] = range;
+    ranges[i].from = (long)pairs * i / count;
+    ranges[i].to = (long)pairs * (i + 1) / count;
+    if(pool)
+      pool_push(pool, margolus_rows, &ranges[i]);
+    else
+      margolus_rows(&ranges[i]);
+  }
+
+  // rows out of the cut (the first one of the odd cut, the last one
+  // with a row left) keep their states
+  Tally t = tally_empty();
+  for(int i = 0; i < b->rows; i++){
+    if(i >= phase && i < phase + 2 * pairs)
+      continue;
+    const uint64_t* row = bitboard_row(b, i);
+    memcpy(b->next + (row - b->data), row, sizeof(uint64_t) * b->words);
+    if(b->tracking)
+      bitboard_tally_row(b, row, row, 0, b->words, i, &t);
+  }
+  if(pool)
+    pool_wait(pool);
+
+  for(int i = 0; i < count; i++)
+    tally_merge(&t, ranges[i].tally);
+  b->hash ^= t.hash;
+  b->tally = t;
+  b->tally.scanned = 1;
+  free(ranges);
+  free(full);
+
+  uint64_t* tmp = b->data;
+  b->data = b->next;
+  b->next = tmp;
+}
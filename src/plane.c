@@ -0,0 +1,104 @@
+#include "utils.h"
+
+/*
+  State plane - compact storage of the cell states used for stepping,
+  separate from the Cell instances which are only used for rendering.
+
+  Hexagon grid is stored in axial (skewed) coordinates:
+
+     offset (row, col)       axial (row, q = col - row/2)
+
+      0 1 2 3                 0 1 2 3
+       0 1 2 3                0 1 2 3
+      0 1 2 3       =>      0 1 2 3
+       0 1 2 3              0 1 2 3
+                          0 1 2 3
+
+  so every cell has the same 6 neighbors at fixed offsets
+
+       -s  -s+1
+     -1   i   +1         (s - stride of the plane)
+       +s-1  +s
+
+  and there is no row parity branching at all. Plane has one dead cell
+  border around, so there is no bounds checks as well.
+  Conversion back to offset coordinates happens only in plane_store(),
+  when states are written to the instance buffer.
+*/
+
+int plane_index(Plane* p, int row, int col){
+  return (row + 1) * p->stride + col - (row >> 1) + p->skew + 1;
+}
+
+int plane_init(Plane* p, Mode mode, int rows, int cols){
+  if(mode != HEXAGON)
+    return 0;
+
+  p->mode = mode;
+  p->rows = rows;
+  p->cols = cols;
+  p->skew = (rows - 1) >> 1;
+  p->stride = cols + p->skew + 2;
+  p->data = calloc(sizeof(unsigned char), p->stride * (rows + 2));
+  p->next = calloc(sizeof(unsigned char), p->stride * (rows + 2));
+  return 1;
+}
+
+void plane_destroy(Plane* p){
+  free(p->data);
+  free(p->next);
+  *p = (Plane){};
+}
+
+void plane_set(Plane* p, int row, int col, unsigned char value){
+  p->data[plane_index(p, row, col)] = value;
+}
+
+void plane_load(Plane* p, Grid in){
+  for(int i = 0; i < in.rows; i++)
+    for(int j = 0; j < in.cols; j++)
+      plane_set(p, i, j, in.data[i * in.cols + j].state == 1.0);
+}
+
+void plane_store(Plane* p, Grid out){
+  for(int i = 0; i < out.rows; i++){
+    unsigned char* row = p->data + plane_index(p, i, 0);
+    for(int j = 0; j < out.cols; j++)
+      out.data[i * out.cols + j].state = row[j];
+  }
+}
+
+/*
+  Next state is (mask[state] >> n) & 1, no branches in the loop
+*/
+void plane_step(Plane* p, Rule rule){
+  unsigned short mask[2] = { rule.birth, rule.survive };
+
+  int s = p->stride;
+  Tally t = tally_empty();
+  for(int i = 0; i < p->rows; i++){
+    const unsigned char* c = p->data + plane_index(p, i, 0);
+    unsigned char* out = p->next + plane_index(p, i, 0);
+
+    for(int j = 0; j < p->cols; j++){
+      int n = c[j - 1] + c[j + 1]
+        + c[j - s] + c[j - s + 1]
+        + c[j + s - 1] + c[j + s];
+      out[j] = (mask[c[j]] >> n) & 1;
+    }
+
+    if(p->tracking)
+      for(int j = 0; j < p->cols; j++){
+        t.births += out[j] > c[j];
+        t.deaths += out[j] < c[j];
+        if(out[j])
+          box_add(&t.alive, i, j);
+      }
+  }
+  t.scanned = 1;
+  p->tally = t;
+
+  unsigned char* tmp = p->data;
+  p->data = p->next;
+  p->next = tmp;
+}
@@ -0,0 +1,178 @@
+#define _POSIX_C_SOURCE 200809L
+#include "utils.h"
+#include <unistd.h>
+
+/*
+  Work-stealing thread pool
+
+  Every worker has its own deque: it pushes and pops its tasks at the
+  bottom (the most recent task is the hottest in cache), idle workers
+  steal from the top of the other deques. When there is nothing to do
+  anywhere, workers sleep until the next push.
+  Deques are small mutex protected rings, tasks are tiny (tile steps),
+  so the lock is never held for long.
+
+  Tasks pushed from a worker go to its own deque, from outside of the
+  pool - round robin over all of them.
+*/
+
+static _Thread_local Pool* worker_pool = NULL;
+static _Thread_local int worker_id = -1;
+
+static void deque_push(Deque* d, PoolTask task){
+  pthread_mutex_lock(&d->lock);
+  if(d->bottom - d->top == d->capacity){
+    int capacity = d->capacity ? d->capacity * 2 : 64;
+    PoolTask* data = malloc(sizeof(PoolTask) * capacity);
+    for(long i = d->top; i < d->bottom; i++)
+      data[i % capacity] = d->data[i % d->capacity];
+    free(d->data);
+    d->data = data;
+    d->capacity = capacity;
+  }
+  d->data[d->bottom++ % d->capacity] = task;
+  pthread_mutex_unlock(&d->lock);
+}
+
+static int deque_pop(Deque* d, PoolTask* out, int steal){
+  int ok = 0;
+  pthread_mutex_lock(&d->lock);
+  if(d->bottom > d->top){
+    *out = steal
+      ? d->data[d->top++ % d->capacity]
+      : d->data[--d->bottom % d->capacity];
+    ok = 1;
+  }
+  pthread_mutex_unlock(&d->lock);
+  return ok;
+}
+
+static int pool_take(Pool* p, int id, PoolTask* out){
+  if(deque_pop(&p->deques[id], out, 0))
+    return 1;
+  for(int i = 1; i < p->threads; i++)
+    if(deque_pop(&p->deques[(id + i) % p->threads], out, 1))
+      return 1;
+  return 0;
+}
+
+static void* pool_worker(void* arg){
+  Pool* p = arg;
+  worker_pool = p;
+  worker_id = atomic_fetch_add(&p->started, 1);
+
+  for(;;){
+    PoolTask task;
+    if(pool_take(p, worker_id, &task)){
+      atomic_fetch_sub(&p->queued, 1);
+      task.fn(task.arg);
+      if(atomic_fetch_sub(&p->pending, 1) == 1){
+        pthread_mutex_lock(&p->lock);
+        pthread_cond_broadcast(&p->idle);
+        pthread_mutex_unlock(&p->lock);
+      }
+      continue;
+    }
+
+    pthread_mutex_lock(&p->lock);
+    while(!p->stop && !atomic_load(&p->queued))
+      pthread_cond_wait(&p->wake, &p->lock);
+    int stop = p->stop;
+    pthread_mutex_unlock(&p->lock);
+    if(stop)
+      return NULL;
+  }
+}
+
+int pool_threads_default(){
+  char* forced = getenv("GOL_THREADS");
+  if(forced && atoi(forced) > 0)
+    return atoi(forced);
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  return cpus > 0 ? cpus : 1;
+}
+
+void pool_init(Pool* p, int threads){
+  *p = (Pool){ .threads = threads > 0 ? threads : pool_threads_default() };
+  pthread_mutex_init(&p->lock, NULL);
+  pthread_cond_init(&p->wake, NULL);
+  pthread_cond_init(&p->idle, NULL);
+
+  p->deques = calloc(sizeof(Deque), p->threads);
+  p->workers = calloc(sizeof(pthread_t), p->threads);
+  for(int i = 0; i < p->threads; i++)
+    pthread_mutex_init(&p->deques[i].lock, NULL);
+  for(int i = 0; i < p->threads; i++)
+    pthread_create(&p->workers[i], NULL, pool_worker, p);
+}
+
+void pool_destroy(Pool* p){
+  if(!p->workers)
+    return;
+
+  pthread_mutex_lock(&p->lock);
+  p->stop = 1;
+  pthread_cond_broadcast(&p->wake);
+  pthread_mutex_unlock(&p->lock);
+
+  for(int i = 0; i < p->threads; i++){
+    pthread_join(p->workers[i], NULL);
+    pthread_mutex_destroy(&p->deques[i].lock);
+    free(p->deques[i].data);
+  }
+  free(p->deques);
+  free(p->workers);
+  pthread_mutex_destroy(&p->lock);
+  pthread_cond_destroy(&p->wake);
+  pthread_cond_destroy(&p->idle);
+  *p = (Pool){};
+}
+
+void pool_push(Pool* p, void (*fn)(void* arg), void* arg){
+  atomic_fetch_add(&p->pending, 1);
+  atomic_fetch_add(&p->queued, 1);
+
+  int id = worker_pool == p
+    ? worker_id
+    : atomic_fetch_add(&p->next, 1) % p->threads;
+  deque_push(&p->deques[id], (PoolTask){ fn, arg });
+
+  pthread_mutex_lock(&p->lock);
+  pthread_cond_signal(&p->wake);
+  pthread_mutex_unlock(&p->lock);
+}
+
+/*
+  Waits until every pushed task (and every task pushed by them) is done
+*/
+void pool_wait(Pool* p){
+  pthread_mutex_lock(&p->lock);
+  while(atomic_load(&p->pending))
+    pthread_cond_wait(&p->idle, &p->lock);
+  pthread_mutex_unlock(&p->lock);
+}
+
+/*
+  Shared pool for the kernels, created on the first use,
+  GOL_THREADS overrides the number of threads
+*/
+static Pool shared = {};
+
+Pool* pool_shared(){
+  if(!shared.workers)
+    pool_init(&shared, 0);
+  return &shared;
+}
+
+/*
+  Shared pool with `threads` threads (0 - default), recreated when it
+  has a different number of them
+*/
+void pool_shared_threads(int threads){
+  if(threads <= 0)
+    threads = pool_threads_default();
+  if(shared.workers && shared.threads == threads)
+    return;
+  pool_destroy(&shared);
+  pool_init(&shared, threads);
+}
@@ -104,13 +104,13 @@ void write_svg(const char *output_file, const char *svg_file){
 
           print_group(g);
 
-          PathParsed p[4] = {};
+          PathParsed p[GROUP_CHILDREN] = {};
 
           int group_vertices_size = 0;
           int group_indices_w_size = 0;
           int group_indices_s_size = 0;
 
-          for(int i=0; i<4; i++){
+          for(int i=0; i<GROUP_CHILDREN; i++){
             p[i] = parse_path(g.children[i]);
             if(!strlen(p[i].name))
               continue;
@@ -143,7 +143,7 @@ void write_svg(const char *output_file, const char *svg_file){
           
           fprintf(out, "const float %s%s[%d] = {\n", "vertices_", g.name,
               group_vertices_size);
-          for(int i=0; i<4; i++){
+          for(int i=0; i<GROUP_CHILDREN; i++){
             if(!strlen(p[i].name))
               continue;
             fprintf(out, "\t");
@@ -155,7 +155,7 @@ void write_svg(const char *output_file, const char *svg_file){
 
           fprintf(out, "const unsigned char %s%s[%d] = {\n", "indices_w_", g.name,
               group_indices_w_size);
-          for(int i=0, k=0; i<4; i++){
+          for(int i=0, k=0; i<GROUP_CHILDREN; i++){
             if(!strlen(p[i].name))
               continue;
             fprintf(out, "\t");
@@ -168,7 +168,7 @@ void write_svg(const char *output_file, const char *svg_file){
 
           fprintf(out, "const unsigned char %s%s[%d] = {\n", "indices_s_", g.name,
               group_indices_s_size);
-          for(int i=0, k=0; i<4; i++){
+          for(int i=0, k=0; i<GROUP_CHILDREN; i++){
             if(!strlen(p[i].name))
               continue;
             fprintf(out, "\t");
@@ -189,6 +189,478 @@ void write_svg(const char *output_file, const char *svg_file){
   // free(...); will be done by OS 
 }
 
+/*
+  Periodic tilings for the graph kernel: every group is a block of tiles
+  repeated by the "Period" path steps (origin, next column, next row),
+  tiles "rRcC" sit in row R, column C of the block. Neighbors are the
+  tiles sharing a vertex, looked up once here over the blocks around, so
+  the kernel only reads them (see graph.c).
+*/
+#define TILING_TILES 8    // tiles of a block
+#define TILING_REACH 2    // blocks around searched for neighbors
+#define TILINGS_MAX 16
+
+typedef struct{
+  char name[16];
+  int rows;
+  int cols;
+  float period[2][2];
+} TilingEntry;
+
+int tiles_touch(PathParsed a, PathParsed b, float dx, float dy){
+  for(int i=0; i<a.vertices.size; i++)
+    for(int j=0; j<b.vertices.size; j++){
+      float x = a.vertices.data[i].x - b.vertices.data[j].x - dx;
+      float y = a.vertices.data[i].y - b.vertices.data[j].y - dy;
+      if(x * x + y * y < 1e-6)
+        return 1;
+    }
+  return 0;
+}
+
+void write_tiling(FILE *out, Group g, TilingEntry *entry){
+  PathParsed period = {};
+  PathParsed tiles[TILING_TILES] = {};
+  int places[TILING_TILES][2] = {};
+  int count = 0;
+
+  *entry = (TilingEntry){};
+  strcpy(entry->name, g.name);
+  for(int i=0; i<GROUP_CHILDREN; i++){
+    PathParsed p = parse_path(g.children[i]);
+    if(!strlen(p.name))
+      continue;
+    if(!strcmp(p.name, "period")){
+      period = p;
+      continue;
+    }
+    int row = 0, col = 0;
+    if(count == TILING_TILES || sscanf(p.name, "r%dc%d", &row, &col) != 2){
+      fprintf(stderr, "Skipping tile %s of %s\n", p.name, g.name);
+      continue;
+    }
+    places[count][0] = row;
+    places[count][1] = col;
+    tiles[count++] = p;
+    if(row + 1 > entry->rows) entry->rows = row + 1;
+    if(col + 1 > entry->cols) entry->cols = col + 1;
+  }
+  if(period.vertices.size != 3 || count != entry->rows * entry->cols){
+    fprintf(stderr, "Incomplete tiling %s\n", g.name);
+    exit(EXIT_FAILURE);
+  }
+
+  // tiles in block order
+  PathParsed block[TILING_TILES] = {};
+  for(int i=0; i<count; i++)
+    block[places[i][0] * entry->cols + places[i][1]] = tiles[i];
+  for(int k=0; k<2; k++){
+    entry->period[k][0] = period.vertices.data[k + 1].x - period.vertices.data[0].x;
+    entry->period[k][1] = period.vertices.data[k + 1].y - period.vertices.data[0].y;
+  }
+
+  fprintf(out, "static const unsigned char tiling_%s_sizes[%d] = {\n\t", g.name, count);
+  for(int t=0; t<count; t++)
+    fprintf(out, "%d, ", block[t].vertices.size);
+  fprintf(out, "\n};\n");
+
+  int vertices_size = 0;
+  for(int t=0; t<count; t++)
+    vertices_size += block[t].vertices.size * 2;
+  fprintf(out, "static const float tiling_%s_vertices[%d] = {\n", g.name, vertices_size);
+  for(int t=0; t<count; t++){
+    fprintf(out, "\t");
+    for(int j=0; j<block[t].vertices.size; j++)
+      fprintf(out, "%.4ff, %.4ff, ", block[t].vertices.data[j].x, block[t].vertices.data[j].y);
+    fprintf(out, "\n");
+  }
+  fprintf(out, "};\n");
+
+  // links of every tile: block offset (rows, cols) and the tile there
+  int links[TILING_TILES][(2 * TILING_REACH + 1) * (2 * TILING_REACH + 1) * TILING_TILES][3];
+  int first[TILING_TILES + 1] = {};
+  for(int t=0; t<count; t++){
+    int n = 0;
+    for(int dr=-TILING_REACH; dr<=TILING_REACH; dr++)
+      for(int dc=-TILING_REACH; dc<=TILING_REACH; dc++)
+        for(int u=0; u<count; u++){
+          if(!dr && !dc && u == t)
+            continue;
+          float dx = dc * entry->period[0][0] + dr * entry->period[1][0];
+          float dy = dc * entry->period[0][1] + dr * entry->period[1][1];
+          if(tiles_touch(block[t], block[u], dx, dy)){
+            links[t][n][0] = dr;
+            links[t][n][1] = dc;
+            links[t][n][2] = u;
+            n++;
+          }
+        }
+    first[t + 1] = first[t] + n;
+  }
+
+  fprintf(out, "static const unsigned short tiling_%s_first[%d] = {\n\t", g.name, count + 1);
+  for(int t=0; t<=count; t++)
+    fprintf(out, "%d, ", first[t]);
+  fprintf(out, "\n};\n");
+
+  fprintf(out, "static const TilingLink tiling_%s_links[%d] = {\n", g.name, first[count]);
+  for(int t=0; t<count; t++){
+    fprintf(out, "\t");
+    for(int n=0; n<first[t + 1] - first[t]; n++)
+      fprintf(out, "{ %d, %d, %d }, ", links[t][n][0], links[t][n][1], links[t][n][2]);
+    fprintf(out, "\n");
+  }
+  fprintf(out, "};\n\n");
+}
+
+void write_tilings(const char *output_file, const char *svg_file){
+  FILE *out = fopen(output_file, "w");
+  if (!out) {
+    perror("Failed to open output file");
+    exit(EXIT_FAILURE);
+  }
+  fprintf(out, "// Auto-generated file with periodic tilings of %s\n\n", svg_file);
+
+  char* buffer = NULL;
+  char* token = NULL;
+  TilingEntry entries[TILINGS_MAX] = {};
+  int count = 0;
+
+  read_file(svg_file, &buffer);
+
+  int finish = 0;
+  do {
+    finish = strtok_(&token, &buffer, '<', (Search_Until){
+      .data = { "\n", " ", ">" }, 
+      .size = 3});
+    if(strcmp("g", token) || count == TILINGS_MAX)
+      continue;
+
+    finish = strtok_(&token, &buffer, 0, (Search_Until){
+      .data = { ">" }, 
+      .size = 1});
+    char * attrs = malloc(strlen(token) + 1);
+    strcpy(attrs, token);
+
+    finish = strtok_(&token, &buffer, 0, (Search_Until){
+      .data = { "/g>" }, 
+      .size = 1});
+    char * body = malloc(strlen(token) + 1);
+    strcpy(body, token);
+
+    write_tiling(out, parse_group(body, attrs), &entries[count++]);
+  } while (!finish);
+
+  fprintf(out, "static const Tiling tilings[%d] = {\n", count);
+  for(int i=0; i<count; i++)
+    fprintf(out, "\t{ \"%s\", %d, %d, { { %.4ff, %.4ff }, { %.4ff, %.4ff } },\n"
+      "\t  tiling_%s_sizes, tiling_%s_vertices, tiling_%s_first, tiling_%s_links },\n",
+      entries[i].name, entries[i].rows, entries[i].cols,
+      entries[i].period[0][0], entries[i].period[0][1],
+      entries[i].period[1][0], entries[i].period[1][1],
+      entries[i].name, entries[i].name, entries[i].name, entries[i].name);
+  fprintf(out, "};\n\n#define TILINGS %d\n", count);
+
+  // free(...); will be done by OS 
+  fclose(out);
+}
+
+/*
+  Rule kernels for the bitboard: every rule of the list is compiled for
+  every mode into a straight-line boolean function of the neighbor count
+  bit planes v[0..3] and the state v[4] - the inputs rule_eval() gets in
+  bitboard.c, without going through the term tables.
+
+  - counts above the neighbors of the mode can not happen, "don't care"
+  - prime implicants of the truth table, then the cover with the fewest
+    gates is searched exhaustively, there are only a few primes
+  - the cover is factored by its most common literal, recursively
+
+  Row kernels and the table of them by (mode, birth, survival) go into
+  kernels.h, bitboard.c includes it after its row steppers.
+*/
+#define KERNEL_VARS 5          // count bit planes and the state
+#define KERNEL_MINTERMS (1 << KERNEL_VARS)
+#define KERNEL_PRIMES 243      // 3^5 - all possible terms
+#define KERNEL_TEXT 4096
+#define KERNELS_MAX 64
+
+typedef struct{
+  unsigned char value;
+  unsigned char care;
+} Term;
+
+typedef struct{
+  Term primes[KERNEL_PRIMES];
+  int size;
+  int on[KERNEL_MINTERMS];
+  int chosen[KERNEL_MINTERMS];   // cover being searched, prime indices
+  int best[KERNEL_MINTERMS];
+  int best_size;
+  int best_cost;
+} Cover;
+
+typedef struct{
+  char name[32];
+  int mode;
+  int birth;
+  int survive;
+} KernelEntry;
+
+int term_covers(Term t, int m){
+  return ((m ^ t.value) & t.care) == 0;
+}
+
+// ands between the literals and nots of the negated ones
+int term_cost(Term t){
+  int literals = __builtin_popcount(t.care);
+  int negated = __builtin_popcount(t.care & ~t.value);
+  return (literals ? literals - 1 : 0) + negated;
+}
+
+void cover_search(Cover *c, const int covered[KERNEL_MINTERMS], int depth, int cost){
+  if(cost >= c->best_cost)
+    return;
+  int m = 0;
+  while(m < KERNEL_MINTERMS && (!c->on[m] || covered[m]))
+    m++;
+  if(m == KERNEL_MINTERMS){
+    memcpy(c->best, c->chosen, sizeof(int) * depth);
+    c->best_size = depth;
+    c->best_cost = cost;
+    return;
+  }
+  // the first uncovered minterm needs one of its primes, try each
+  for(int p=0; p<c->size; p++){
+    if(!term_covers(c->primes[p], m))
+      continue;
+    int next[KERNEL_MINTERMS];
+    for(int k=0; k<KERNEL_MINTERMS; k++)
+      next[k] = covered[k] || term_covers(c->primes[p], k);
+    c->chosen[depth] = p;
+    cover_search(c, next, depth + 1, cost + term_cost(c->primes[p]) + (depth > 0));
+  }
+}
+
+void term_text(char *out, Term t){
+  out[0] = '\0';
+  for(int k=0; k<KERNEL_VARS; k++){
+    if(!((t.care >> k) & 1))
+      continue;
+    sprintf(out + strlen(out), "%s%sv[%d]", strlen(out) ? " & " : "",
+      (t.value >> k) & 1 ? "" : "~", k);
+  }
+}
+
+/*
+  Sum of the terms into `out`, factored: the literal found in most terms
+  is taken out of them, the rest is or-ed. Returns gates.
+*/
+int factor_terms(char *out, const Term *terms, int size){
+  for(int i=0; i<size; i++)
+    if(!terms[i].care){
+      strcpy(out, "~0ull");
+      return 0;
+    }
+
+  int counts[KERNEL_VARS][2] = {};
+  int best_var = 0, best_value = 0;
+  for(int i=0; i<size; i++)
+    for(int k=0; k<KERNEL_VARS; k++)
+      if((terms[i].care >> k) & 1){
+        int value = (terms[i].value >> k) & 1;
+        if(++counts[k][value] > counts[best_var][best_value]){
+          best_var = k;
+          best_value = value;
+        }
+      }
+
+  if(size == 1 || counts[best_var][best_value] < 2){
+    int gates = size - 1;
+    out[0] = '\0';
+    for(int i=0; i<size; i++){
+      char term[256];
+      term_text(term, terms[i]);
+      int wrap = size > 1 && strchr(term, '&');
+      sprintf(out + strlen(out), wrap ? "%s(%s)" : "%s%s", i ? " | " : "", term);
+      gates += term_cost(terms[i]);
+    }
+    return gates;
+  }
+
+  Term with[KERNEL_PRIMES], rest[KERNEL_PRIMES];
+  int with_size = 0, rest_size = 0;
+  for(int i=0; i<size; i++){
+    Term t = terms[i];
+    if(((t.care >> best_var) & 1) && ((t.value >> best_var) & 1) == best_value){
+      t.care &= ~(1 << best_var);
+      t.value &= ~(1 << best_var);
+      with[with_size++] = t;
+    }
+    else
+      rest[rest_size++] = t;
+  }
+
+  char inner[KERNEL_TEXT];
+  int gates = factor_terms(inner, with, with_size) + !best_value;
+  const char *literal = best_value ? "" : "~";
+  if(!strcmp(inner, "~0ull"))
+    sprintf(out, "%sv[%d]", literal, best_var);
+  else {
+    sprintf(out, "%sv[%d] & (%s)", literal, best_var, inner);
+    gates++;
+  }
+  if(rest_size){
+    char other[KERNEL_TEXT];
+    gates += factor_terms(other, rest, rest_size) + 1;
+    char both[2 * KERNEL_TEXT + 8];
+    sprintf(both, strchr(other, '&') ? "(%s) | (%s)" : "(%s) | %s", out, other);
+    strcpy(out, both);
+  }
+  return gates;
+}
+
+/*
+  Minimal expression of the rule, neighbors above `max` never happen.
+  Returns gates.
+*/
+int compile_rule(char *out, int birth, int survive, int max){
+  int on[KERNEL_MINTERMS] = {}, off[KERNEL_MINTERMS] = {};
+  for(int m=0; m<KERNEL_MINTERMS; m++){
+    int n = m & 15, state = m >> 4;
+    if(n > max)
+      continue;
+    on[m] = (((state ? survive : birth) >> n) & 1);
+    off[m] = !on[m];
+  }
+
+  // implicants covering no "off" minterm, primes - those which can not
+  // drop any variable
+  Cover *c = calloc(1, sizeof(Cover));
+  memcpy(c->on, on, sizeof(on));
+  for(int care=0; care<KERNEL_MINTERMS; care++)
+    for(int value=0; value<KERNEL_MINTERMS; value++){
+      if(value & ~care)
+        continue;
+      Term t = { value, care };
+      int valid = 1, useful = 0;
+      for(int m=0; m<KERNEL_MINTERMS; m++)
+        if(term_covers(t, m)){
+          valid &= !off[m];
+          useful |= on[m];
+        }
+      if(!valid || !useful)
+        continue;
+      int prime = 1;
+      for(int k=0; k<KERNEL_VARS && prime; k++){
+        if(!((care >> k) & 1))
+          continue;
+        Term wider = { value & ~(1 << k), care & ~(1 << k) };
+        int wider_valid = 1;
+        for(int m=0; m<KERNEL_MINTERMS; m++)
+          wider_valid &= !(term_covers(wider, m) && off[m]);
+        prime = !wider_valid;
+      }
+      if(prime)
+        c->primes[c->size++] = t;
+    }
+
+  int covered[KERNEL_MINTERMS] = {};
+  c->best_cost = 1 << 30;
+  cover_search(c, covered, 0, 0);
+
+  int gates = 0;
+  if(!c->best_size)
+    strcpy(out, "0");
+  else {
+    Term terms[KERNEL_MINTERMS];
+    for(int i=0; i<c->best_size; i++)
+      terms[i] = c->primes[c->best[i]];
+    gates = factor_terms(out, terms, c->best_size);
+  }
+  free(c);
+  return gates;
+}
+
+int parse_counts(const char **text, char letter){
+  int mask = 0;
+  if(toupper(**text) != letter)
+    return -1;
+  for((*text)++; isdigit(**text); (*text)++)
+    mask |= 1 << (**text - '0');
+  return mask;
+}
+
+// rule names go into the function names of the kernels
+int is_identifier(const char *name){
+  if(!isalpha(*name) && *name != '_')
+    return 0;
+  for(name++; *name; name++)
+    if(!isalnum(*name) && *name != '_')
+      return 0;
+  return 1;
+}
+
+void write_kernels(const char *output_file, const char *rules_file){
+  const char *modes[] = { "TRIGON", "TETRAGON", "HEXAGON" };
+  const char *names[] = { "trigon", "tetragon", "hexagon" };
+  const int neighbors[] = { 12, 8, 6 };   // as neighbors_max()
+
+  FILE *out = fopen(output_file, "w");
+  if (!out) {
+    perror("Failed to open output file");
+    exit(EXIT_FAILURE);
+  }
+  fprintf(out, "// Auto-generated file with rule kernels of %s\n\n", rules_file);
+
+  char* buffer = NULL;
+  read_file(rules_file, &buffer);
+
+  KernelEntry entries[KERNELS_MAX] = {};
+  int count = 0;
+  for(char *line = strtok(buffer, "\n"); line; line = strtok(NULL, "\n")){
+    char name[32], text[64];
+    if(line[0] == '#' || sscanf(line, "%31s %63s", name, text) != 2)
+      continue;
+    const char *c = text;
+    int birth = parse_counts(&c, 'B');
+    c += *c == '/';
+    int survive = parse_counts(&c, 'S');
+    if(birth < 0 || survive < 0 || *c || !is_identifier(name)){
+      fprintf(stderr, "Skipping rule %s %s\n", name, text);
+      continue;
+    }
+
+    for(int m=0; m<3 && count<KERNELS_MAX; m++){
+      int valid = (2 << neighbors[m]) - 1;
+      char expr[KERNEL_TEXT];
+      int gates = compile_rule(expr, birth & valid, survive & valid, neighbors[m]);
+
+      fprintf(out, "// %s on %s (%s), %d gates\n", name, names[m], text, gates);
+      fprintf(out, "static inline uint64_t rule_%s_%s(const RuleExpr* e, const uint64_t v[RULE_VARS]){\n"
+        "  return %s;\n}\n\n", names[m], name, expr);
+      fprintf(out, "static void row_%s_%s(\n"
+        "  const uint64_t* u,\n  const uint64_t* c,\n  const uint64_t* d,\n  uint64_t* out,\n"
+        "  int from,\n  int to,\n  int odd){\n"
+        "    step_row_%s(u, c, d, out, from, to, %sNULL, rule_%s_%s);\n}\n\n",
+        names[m], name, names[m], strcmp(names[m], "tetragon") ? "odd, " : "", names[m], name);
+
+      entries[count++] = (KernelEntry){ .mode = m, .birth = birth & valid, .survive = survive & valid };
+      strcpy(entries[count - 1].name, name);
+    }
+  }
+
+  fprintf(out, "static const CompiledKernel kernels[%d] = {\n", count);
+  for(int i=0; i<count; i++)
+    fprintf(out, "\t{ %s, 0x%03x, 0x%03x, \"%s\", row_%s_%s },\n",
+      modes[entries[i].mode], entries[i].birth, entries[i].survive, entries[i].name,
+      names[entries[i].mode], entries[i].name);
+  fprintf(out, "};\n\n#define KERNELS %d\n", count);
+
+  // free(...); will be done by OS
+  fclose(out);
+}
+
 int main() {
   const char *output_shaders_file = "build/resources.c";
 
@@ -221,5 +693,15 @@ int main() {
     
   printf("SVG sources successfully embedded in %s\n", output_svg_file);
 
+  const char *output_tilings_file = "build/tilings.h";
+  write_tilings(output_tilings_file, "src/resources/tilings.svg");
+
+  printf("Tilings successfully generated in %s\n", output_tilings_file);
+
+  const char *output_kernels_file = "build/kernels.h";
+  write_kernels(output_kernels_file, "src/resources/rules.txt");
+
+  printf("Rule kernels successfully generated in %s\n", output_kernels_file);
+
   return 0;
 }
@@ -0,0 +1,159 @@
+#include "utils.h"
+
+/*
+  Random fill - reproducible soups of any density
+
+  Cell (row, col) of the soup is bit col % 64 of random_word() of the
+  word (row, col / 64) - it depends on its position and the seed only,
+  so the soup is the same whether it is made by one thread or many, in
+  the bitboard or in the cells of a grid.
+
+  Density is threshold / 2^RANDOM_BITS. 64 cells are drawn at once:
+  RANDOM_BITS random words are the bit planes of 64 random numbers,
+  which are compared with the threshold bit-sliced, from the lowest
+  plane up:
+
+      less = threshold bit ? less | ~plane : less & ~plane
+
+  planes below the lowest set bit of the threshold can not change
+  `less`, so they are not drawn - density 1/2 is a single
+  counter_random() per 64 cells, 1/4 - two of them.
+
+  Stochastic rules draw the same way in the step (random_chance()), with
+  the word keyed by the generation too, so runs are the same at any
+  thread count and in any order of rows or tiles.
+*/
+
+#define RANDOM_BITS 16
+#define RANDOM_RANGES 4   // ranges of rows per thread
+
+unsigned random_threshold(double density){
+  if(density <= 0.0)
+    return 0;
+  if(density >= 1.0)
+    return 1u << RANDOM_BITS;
+  return density * (1u << RANDOM_BITS) + 0.5;
+}
+
+static inline uint64_t random_word(uint64_t seed, uint64_t word, unsigned threshold){
+  if(threshold >> RANDOM_BITS)
+    return ~0ull;
+  uint64_t less = 0;
+  for(int b = threshold ? __builtin_ctz(threshold) : RANDOM_BITS; b < RANDOM_BITS; b++){
+    uint64_t plane = counter_random(seed, word * RANDOM_BITS + b);
+    less = (threshold >> b) & 1 ? less | ~plane : less & ~plane;
+  }
+  return less;
+}
+
+/*
+  64 draws with two densities at once - threshold[1] in the lanes set in
+  `lanes`, threshold[0] in the others (alive and dead cells of a word,
+  survival and birth of a stochastic rule)
+*/
+uint64_t random_chance(uint64_t seed, uint64_t word, uint64_t lanes, const unsigned threshold[2]){
+  uint64_t sure = (threshold[0] >> RANDOM_BITS ? ~lanes : 0) | (threshold[1] >> RANDOM_BITS ? lanes : 0);
+  unsigned low = (threshold[0] | threshold[1]) & ((1u << RANDOM_BITS) - 1);
+  uint64_t less = 0;
+  for(int b = low ? __builtin_ctz(low) : RANDOM_BITS; b < RANDOM_BITS; b++){
+    uint64_t plane = counter_random(seed, word * RANDOM_BITS + b);
+    uint64_t set = ((threshold[0] >> b) & 1 ? ~lanes : 0) | ((threshold[1] >> b) & 1 ? lanes : 0);
+    less = (set & (less | ~plane)) | (~set & less & ~plane);
+  }
+  return less | sure;
+}
+
+void grid_random(Grid g, uint64_t seed, double density){
+  unsigned threshold = random_threshold(density);
+  int words = (g.cols + 63) / 64;
+  for(int i = 0; i < g.rows; i++)
+    for(int w = 0; w < words; w++){
+      uint64_t bits = random_word(seed, (uint64_t)i * words + w, threshold);
+      for(int j = w * 64; j < g.cols && j < w * 64 + 64; j++)
+        g.data[i * g.cols + j].state = (bits >> (j % 64)) & 1;
+    }
+}
+
+typedef struct{
+  Bitboard* b;
+  uint64_t seed;
+  unsigned threshold;
+  int from;             // rows [from, to)
+  int to;
+  long first;           // grid row of row 0, bitboard may be a part
+  long population;
+  uint64_t hash;
+} RandomRange;
+
+static void random_rows(void* arg){
+  RandomRange* r = arg;
+  Bitboard* b = r->b;
+  for(int i = r->from; i < r->to; i++){
+    uint64_t* row = bitboard_row(b, i);
+    for(int w = 0; w < b->words; w++)
+      row[w] = random_word(r->seed, (uint64_t)(r->first + i) * b->words + w, r->threshold);
+    row[b->words - 1] &= b->tail;
+
+    for(int w = 0; w < b->words; w++)
+      r->population += popcount(row[w]);
+    if(b->hashing)
+      for(int w = 0; w < b->words; w++)
+        r->hash ^= zobrist_word(row + w - b->data, row[w]);
+  }
+}
+
+/*
+  Rows [from, to) only, the same states as of the whole bitboard, or of
+  the grid the bitboard is a part of, from its row `first` (domain.c).
+  Returns their population.
+*/
+long bitboard_random_rows(Bitboard* b, uint64_t seed, double density, int from, int to, int first){
+  RandomRange range = {
+    .b = b,
+    .seed = seed,
+    .threshold = random_threshold(density),
+    .from = from,
+    .to = to,
+    .first = first
+  };
+  random_rows(&range);
+  return range.population;
+}
+
+/*
+  Whole bitboard, rows in ranges on the pool (or right away without it),
+  returns the population
+*/
+long bitboard_random(Bitboard* b, uint64_t seed, double density, Pool* pool){
+  int count = pool ? pool->threads * RANDOM_RANGES : 1;
+  if(count > b->rows)
+    count = b->rows;
+
+  RandomRange* ranges = calloc(sizeof(RandomRange), count + 1);
+  for(int i = 0; i < count; i++){
+    ranges[i] = (RandomRange){
+      .b = b,
+      .seed = seed,
+      .threshold = random_threshold(density),
+      .from = (long)b->rows * i / count,
+      .to = (long)b->rows * (i + 1) / count
+    };
+    if(pool)
+      pool_push(pool, random_rows, &ranges[i]);
+    else
+      random_rows(&ranges[i]);
+  }
+  if(pool)
+    pool_wait(pool);
+
+  long population = 0;
+  uint64_t hash = 0;
+  for(int i = 0; i < count; i++){
+    population += ranges[i].population;
+    hash ^= ranges[i].hash;
+  }
+  if(b->hashing)
+    b->hash = hash;
+  free(ranges);
+  return population;
+}
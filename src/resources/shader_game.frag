@@ -3,15 +3,28 @@ in vec3 fragColor;
 in float fragState;
 in vec2 texCoord;
 uniform sampler2D uGridTexture;
+uniform float uStates;  // of the Generations rule, 2 - life
+uniform float uLevels;  // states are levels 0 .. 1 (Lenia)
 out vec4 FragColor;
 
 void main() {
+    if(uLevels > 0.0 && fragState <= 1.0){
+      // brightness by the level, empty cells show the background
+      if(fragState < 0.02)
+        discard;
+      FragColor = vec4(fragColor * fragState, 1.0);
+      return;
+    }
     if(fragState < 0.5){ 
       discard; 
     } else if(fragState < 1.0){ 
       FragColor = texture(uGridTexture, texCoord);
-    } else { 
+    } else if(fragState < 1.5){ 
       FragColor = vec4(fragColor, 1.0);
+    } else {
+      // decaying cells (states 2 ..) fade out
+      float age = (fragState - 1.0) / uStates;
+      FragColor = vec4(fragColor * vec3(1.0, 0.55, 0.2) * (1.0 - age), 1.0);
     }
 };
     
\ No newline at end of file
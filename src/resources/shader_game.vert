@@ -2,7 +2,7 @@
     layout (location = 0) in vec2 aPos;   // vertex position
     layout (location = 1) in vec3 iColor; // color defined in instance
     layout (location = 2) in vec3 iPos;   // position shift and vertical flip defined in instance
-    layout (location = 3) in float iState;// state (0/1) defined in instance
+    layout (location = 3) in float iState;// state (0/0.5/1, 2.. decaying) defined in instance
     uniform mat4 uProjection;             // projection matrix for viewport setup
     uniform vec3 uColor;                  // if need to override instance color 
                                           //   (example: for wireframe grid has to in one color)
@@ -0,0 +1,324 @@
+#include "utils.h"
+#include <ctype.h>
+
+/*
+  Rule - birth and survival sets as bit masks over the neighbor count
+
+  next_generation(U, O, R) semantics:
+  - any cell with n == R becomes alive
+  - any alive cell with U <= n <= O stays alive
+  - everything else dies
+
+  so it is B{R}/S{U..O, R}, (2,3,3) is the classic B3/S23
+*/
+Rule rule_from_uor(char u, char o, char r){
+  Rule rule = { .birth = 1 << r, .survive = 1 << r };
+  for(int n = u; n <= o; n++)
+    rule.survive |= 1 << n;
+  return rule;
+}
+
+/*
+  Isotropic non-totalistic rule in Hensel notation
+
+      B2-a3/S12ek       B3/S23
+
+  every neighbor count is followed by letters of the shapes of its
+  neighbors (or by '-' and the shapes it is not), a count without letters
+  is every shape of it. Shapes are taken with all of their rotations and
+  reflections. Neighborhood is 9 bits, row by row, bit 4 - the cell:
+
+      0 1 2
+      3 4 5
+      6 7 8
+
+  Shapes of counts above 4 are the complements of 8 - count ones.
+  Rule gets the next state of every neighborhood (rule.neighborhoods),
+  totalistic ones (B3/S23) - the usual masks, so that any kernel steps
+  them. Returns 0 if the text is not such a rule.
+*/
+static const char* hensel_letters[5] = { "", "ce", "ceaikn", "ceaiknjqry", "ceaiknjqrytwz" };
+static const short hensel_shapes[5][13] = {
+  {},
+  { 1, 2 },
+  { 5, 10, 3, 40, 33, 68 },
+  { 69, 42, 11, 7, 98, 13, 14, 70, 41, 97 },
+  { 325, 170, 15, 45, 99, 71, 106, 102, 43, 101, 105, 78, 108 }
+};
+
+#define HENSEL_RING 0x1ef   // all neighbors, without the cell
+
+static int hensel_transform(int shape, int t){
+  int out = 0;
+  for(int k = 0; k < 9; k++){
+    if(!((shape >> k) & 1))
+      continue;
+    int row = k / 3, col = k % 3;
+    for(int r = 0; r < (t & 3); r++){   // quarter turns
+      int tmp = row;
+      row = col;
+      col = 2 - tmp;
+    }
+    if(t & 4)
+      col = 2 - col;
+    out |= 1 << (row * 3 + col);
+  }
+  return out;
+}
+
+static void hensel_add(Rule* rule, int state, int count, int letter){
+  int shape = count <= 4 ? hensel_shapes[count][letter]
+    : HENSEL_RING ^ hensel_shapes[8 - count][letter];
+  for(int t = 0; t < 8; t++){
+    int k = hensel_transform(shape, t) | state << 4;
+    rule->neighborhoods[k >> 6] |= 1ull << (k & 63);
+  }
+}
+
+int rule_from_hensel(const char* text, Rule* out){
+  Rule rule = {};
+  int state = -1;
+  for(const char* c = text; *c;){
+    int ch = tolower(*c);
+    if(ch == 'b' || ch == 's'){
+      state = ch == 's';
+      c++;
+      continue;
+    }
+    if(ch == '/'){
+      c++;
+      continue;
+    }
+    if(ch < '0' || ch > '8' || state < 0)
+      return 0;
+
+    int count = ch - '0';
+    const char* letters = hensel_letters[count <= 4 ? count : 8 - count];
+    int shapes = count == 0 || count == 8 ? 1 : strlen(letters);
+    int negate = *++c == '-';
+    c += negate;
+    unsigned int chosen = 0;
+    for(; *c && isalpha(*c) && tolower(*c) != 'b' && tolower(*c) != 's'; c++){
+      const char* letter = strchr(letters, tolower(*c));
+      if(!letter || !*letters)
+        return 0;
+      chosen |= 1 << (letter - letters);
+    }
+    if(negate && !chosen)
+      return 0;
+    if(!chosen)
+      chosen = ~0u;
+    else if(negate)
+      chosen = ~chosen;
+
+    for(int letter = 0; letter < shapes; letter++)
+      if((chosen >> letter) & 1)
+        hensel_add(&rule, state, count, letter);
+  }
+  if(state < 0)
+    return 0;
+
+  // totalistic - every shape of the count has the same next state
+  int next[2][9];
+  memset(next, -1, sizeof(next));
+  int totalistic = 1;
+  for(int k = 0; k < 512; k++){
+    int n = __builtin_popcount(k & HENSEL_RING), cell = (k >> 4) & 1;
+    int value = (rule.neighborhoods[k >> 6] >> (k & 63)) & 1;
+    totalistic &= next[cell][n] < 0 || next[cell][n] == value;
+    next[cell][n] = value;
+  }
+  rule.isotropic = !totalistic;
+  for(int n = 0; n < 9 && totalistic; n++){
+    rule.birth |= next[0][n] << n;
+    rule.survive |= next[1][n] << n;
+  }
+  *out = rule;
+  return 1;
+}
+
+/*
+  Next state of the 3x3 neighborhood (bits as in rule_from_hensel())
+*/
+int rule_next(Rule rule, int neighborhood){
+  if(rule.isotropic)
+    return (rule.neighborhoods[neighborhood >> 6] >> (neighborhood & 63)) & 1;
+  int n = __builtin_popcount(neighborhood & HENSEL_RING);
+  return (((neighborhood >> 4) & 1 ? rule.survive : rule.birth) >> n) & 1;
+}
+
+/*
+  Larger than Life rule in the usual notation
+
+      R5,C0,M1,S34..58,B34..45,NM
+
+  R - radius, C - states (0 / 2 - life, no decay), M1 - the cell is
+  counted with its neighbors, S / B - survival and birth count ranges,
+  N - neighborhood: M (box) or H (hex rings), it follows the grid mode
+  anyway. Returns 0 if the text is not such a rule.
+*/
+int rule_from_ltl(const char* text, Rule* out){
+  int r, c, m, s0, s1, b0, b1, end = 0;
+  if(sscanf(text, "R%d,C%d,M%d,S%d..%d,B%d..%d%n", &r, &c, &m, &s0, &s1, &b0, &b1, &end) != 7
+      || r < 1 || r > 255 || c > 2 || (m != 0 && m != 1)
+      || (text[end] && strcmp(text + end, ",NM") && strcmp(text + end, ",NH")))
+    return 0;
+
+  *out = (Rule){
+    .radius = r,
+    .middle = m,
+    .births = { b0, b1 },
+    .survivals = { s0, s1 }
+  };
+  // radius 1 counts without the cell fit the masks, so the other kernels
+  // step it too
+  for(int n = 0; n < 16 && r == 1 && !m; n++){
+    out->birth |= (b0 <= n && n <= b1) << n;
+    out->survive |= (s0 <= n && n <= s1) << n;
+  }
+  return 1;
+}
+
+/*
+  Stochastic variant of the rule
+
+      0.5         births by chance 0.5, survivals always
+      0.5,0.99    and survivals by chance 0.99
+
+  chances are 0 .. 1. Returns 0 if the text is not such chances.
+*/
+int rule_chance(const char* text, Rule* rule){
+  float birth, survive = 1;
+  int end = 0;
+  if(sscanf(text, "%f%n,%f%n", &birth, &end, &survive, &end) < 1
+      || text[end] || birth < 0 || birth > 1 || survive < 0 || survive > 1)
+    return 0;
+  rule->stochastic = 1;
+  rule->birth_chance = birth;
+  rule->survive_chance = survive;
+  return 1;
+}
+
+/*
+  Default Lenia rule - Orbium
+*/
+Rule rule_lenia_default(){
+  return (Rule){ .radius = 13, .mu = 0.15, .sigma = 0.015, .dt = 0.1 };
+}
+
+/*
+  Lenia rule in the usual notation
+
+      R13,T10,m0.15,s0.015
+
+  R - kernel radius, T - steps per unit of time (dt = 1 / T), m and s -
+  growth center and width. Returns 0 if the text is not such a rule.
+*/
+int rule_from_lenia(const char* text, Rule* out){
+  int r, t, end = 0;
+  float m, s;
+  if(sscanf(text, "R%d,T%d,m%f,s%f%n", &r, &t, &m, &s, &end) != 4
+      || text[end] || r < 1 || r > 255 || t < 1 || s <= 0)
+    return 0;
+  *out = (Rule){ .radius = r, .dt = 1.0 / t, .mu = m, .sigma = s };
+  return 1;
+}
+
+/*
+  Boolean expression of the rule for bit-sliced kernels
+
+  Variables are the bit planes of the neighbor count (v[0] - lowest bit,
+  up to RULE_BITS) and the current state (v[RULE_BITS]). Expression is a
+  sum of products, generated from the rule truth table:
+  - counts above `max` can not happen, so they are "don't care"
+  - prime implicants are found by merging terms which differ in exactly
+    one variable (Quine-McCluskey)
+  - then greedily picked until every "on" minterm is covered
+
+  Term is stored as two masks per variable, so that the evaluation in
+  rule_eval() is branchless: (v ^ inv) | dc
+*/
+typedef struct{
+  unsigned char value;
+  unsigned char care;
+} Implicant;
+
+#define RULE_MINTERMS (1 << RULE_VARS)
+
+static int rule_minterm(Rule rule, int max, int m, int* dont_care){
+  int n = m & ((1 << RULE_BITS) - 1);
+  int state = m >> RULE_BITS;
+  *dont_care = n > max;
+  return ((state ? rule.survive : rule.birth) >> n) & 1;
+}
+
+static int implicant_covers(Implicant t, int m){
+  return ((m ^ t.value) & t.care) == 0;
+}
+
+void rule_compile(Rule rule, int max, RuleExpr* out){
+  Implicant list[243] = {}; int size = 0;    // 3^5 - all possible terms
+  Implicant primes[243] = {}; int primes_size = 0;
+  int on[RULE_MINTERMS] = {};
+
+  for(int m = 0; m < RULE_MINTERMS; m++){
+    int dont_care = 0;
+    on[m] = rule_minterm(rule, max, m, &dont_care) && !dont_care;
+    if(on[m] || dont_care)
+      list[size++] = (Implicant){ m, RULE_MINTERMS - 1 };
+  }
+
+  while(size){
+    Implicant merged[243] = {}; int merged_size = 0;
+    char used[243] = {};
+
+    for(int i = 0; i < size; i++)
+      for(int j = i + 1; j < size; j++){
+        int diff = (list[i].value ^ list[j].value) & list[i].care;
+        if(list[i].care != list[j].care || __builtin_popcount(diff) != 1)
+          continue;
+        used[i] = used[j] = 1;
+
+        Implicant t = { list[i].value & ~diff, list[i].care & ~diff };
+        int k = 0;
+        while(k < merged_size
+          && (merged[k].value != t.value || merged[k].care != t.care))
+          k++;
+        if(k == merged_size)
+          merged[merged_size++] = t;
+      }
+
+    for(int i = 0; i < size; i++)
+      if(!used[i])
+        primes[primes_size++] = list[i];
+
+    memcpy(list, merged, sizeof(Implicant) * merged_size);
+    size = merged_size;
+  }
+
+  out->size = 0;
+  for(;;){
+    int best = -1, best_count = 0;
+    for(int i = 0; i < primes_size; i++){
+      int count = 0;
+      for(int m = 0; m < RULE_MINTERMS; m++)
+        count += on[m] && implicant_covers(primes[i], m);
+      if(count > best_count){
+        best = i;
+        best_count = count;
+      }
+    }
+    if(best < 0)
+      break;
+
+    for(int m = 0; m < RULE_MINTERMS; m++)
+      if(implicant_covers(primes[best], m))
+        on[m] = 0;
+
+    for(int k = 0; k < RULE_VARS; k++){
+      out->inv[out->size][k] = (primes[best].value >> k) & 1 ? 0 : ~0ull;
+      out->dc[out->size][k] = (primes[best].care >> k) & 1 ? 0 : ~0ull;
+    }
+    out->size++;
+  }
+}
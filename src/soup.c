@@ -0,0 +1,341 @@
+#include "utils.h"
+
+/*
+  Soup search - many small random soups run to the end, objects they
+  leave are counted by shape
+
+  64 soups are one batch, stepped together: a word holds the same cell
+  of all of them, bit = soup (lane). Step of a cell is the sum of its
+  neighbor words by full adders and the compiled rule (see rule_eval())
+  on them, so a cell of 64 soups costs the same as a cell of one and
+  every mode and rule run by the same code - neighbors are the mode
+  offsets (see neighbors_offsets()).
+
+  Storage has a dead border of 1 row and 2 columns like the counts plane
+  (trigon reaches col +- 2), so soups are finite and nothing leaves them.
+
+  Soups are seeded by counter_random() of (seed, batch, cell), soup n
+  is the same whatever the number of threads or soups in the run, and
+  a search can be continued from any soup. A batch runs until every
+  soup in it repeats the state 2 generations back (still lifes and
+  period 2 oscillators only) or for `generations`, after that each soup
+  goes through the census (see census_run()). Batches are spread over
+  the pool in ranges, every range collects its shapes and they are
+  merged at the end, ordered by count.
+*/
+
+#define SOUP_LANES 64
+#define SOUP_RANGES 8    // ranges of batches per thread
+
+typedef struct{
+  Mode mode;
+  int size;
+  int stride;
+  uint64_t* data;       // current states of 64 soups, with dead border
+  uint64_t* next;       // state 2 generations back, then the next one
+  long offsets[2][12];
+  int degree[2];
+} SoupBatch;
+
+typedef struct{
+  Mode mode;
+  RuleExpr expr;
+  int size;
+  int generations;
+  uint64_t seed;
+  long soups;
+  long from;            // batches [from, to)
+  long to;
+  CensusEntry* entries;
+  int count;
+  int capacity;
+  long settled;         // soups which ended in a still life / period 2
+} SoupRange;
+
+static void soup_init(SoupBatch* s, Mode mode, int size){
+  *s = (SoupBatch){ .mode = mode, .size = size, .stride = size + 4 };
+  s->data = calloc(sizeof(uint64_t), (long)s->stride * (size + 2));
+  s->next = calloc(sizeof(uint64_t), (long)s->stride * (size + 2));
+  neighbors_offsets(mode, s->stride, s->offsets, s->degree);
+}
+
+static void soup_destroy(SoupBatch* s){
+  free(s->data);
+  free(s->next);
+  *s = (SoupBatch){};
+}
+
+static long soup_index(SoupBatch* s, int row, int col){
+  return (long)(row + 1) * s->stride + col + 2;
+}
+
+/*
+  Random cells of the batch, lanes above `lanes` stay empty
+*/
+static void soup_seed(SoupBatch* s, uint64_t seed, long batch, int lanes){
+  uint64_t mask = lanes < SOUP_LANES ? (1ull << lanes) - 1 : ~0ull;
+  long cells = (long)s->size * s->size;
+  for(int i = 0; i < s->size; i++)
+    for(int j = 0; j < s->size; j++){
+      long index = soup_index(s, i, j);
+      s->data[index] = counter_random(seed, batch * cells + i * s->size + j) & mask;
+      s->next[index] = 0;
+    }
+}
+
+/*
+  Neighbor count planes v[0..3] of the neighbor words, reduced by full
+  adders the same way as in the bitboard steps
+*/
+static inline void soup_count(Mode mode, const uint64_t* n, uint64_t* v){
+  switch(mode){
+    case TRIGON: {
+      uint64_t s0, s1, s2, s3, c0, c1, c2, c3, t0, k0, k1, e0, e1, f0, f1, g;
+      full_add(n[0], n[1], n[2], &s0, &c0);
+      full_add(n[3], n[4], n[5], &s1, &c1);
+      full_add(n[6], n[7], n[8], &s2, &c2);
+      full_add(n[9], n[10], n[11], &s3, &c3);
+      full_add(s0, s1, s2, &t0, &k0);
+      half_add(t0, s3, &v[0], &k1);
+      full_add(c0, c1, c2, &e0, &f0);
+      full_add(c3, k0, k1, &e1, &f1);
+      half_add(e0, e1, &v[1], &g);
+      full_add(f0, f1, g, &v[2], &v[3]);
+      break;
+    }
+    case HEXAGON: {
+      uint64_t s0, s1, c0, c1, c2;
+      full_add(n[0], n[1], n[2], &s0, &c0);
+      full_add(n[3], n[4], n[5], &s1, &c1);
+      v[0] = s0 ^ s1;
+      c2 = s0 & s1;
+      full_add(c0, c1, c2, &v[1], &v[2]);
+      v[3] = 0;
+      break;
+    }
+    case TETRAGON:
+    default: {
+      uint64_t s0, s1, s2, c0, c1, c2, k0, e, f, g;
+      full_add(n[0], n[1], n[2], &s0, &c0);
+      full_add(n[3], n[4], n[5], &s1, &c1);
+      half_add(n[6], n[7], &s2, &c2);
+      full_add(s0, s1, s2, &v[0], &k0);
+      full_add(c0, c1, c2, &e, &f);
+      half_add(e, k0, &v[1], &g);
+      half_add(f, g, &v[2], &v[3]);
+      break;
+    }
+  }
+}
+
+/*
+  One generation of the batch, returns lanes which changed against the
+  state 2 generations back (it is overwritten anyway)
+*/
+static uint64_t soup_step(SoupBatch* s, const RuleExpr* expr){
+  uint64_t changed = 0;
+  for(int i = 0; i < s->size; i++)
+    for(int j = 0; j < s->size; j++){
+      long index = soup_index(s, i, j);
+      int class = s->mode == TRIGON ? (i + j) & 1 : s->mode == HEXAGON ? i & 1 : 0;
+
+      uint64_t n[12] = {0}, v[RULE_VARS];
+      for(int k = 0; k < s->degree[class]; k++)
+        n[k] = s->data[index + s->offsets[class][k]];
+      soup_count(s->mode, n, v);
+      v[RULE_BITS] = s->data[index];
+
+      uint64_t next = rule_eval(expr, v);
+      changed |= next ^ s->next[index];
+      s->next[index] = next;
+    }
+
+  uint64_t* tmp = s->data;
+  s->data = s->next;
+  s->next = tmp;
+  return changed;
+}
+
+static void soup_add(SoupRange* r, CensusEntry e){
+  if(r->count == r->capacity){
+    r->capacity = r->capacity ? r->capacity * 2 : 256;
+    r->entries = realloc(r->entries, sizeof(CensusEntry) * r->capacity);
+  }
+  r->entries[r->count++] = e;
+}
+
+static int compare_hash(const void* a, const void* b){
+  const CensusEntry* x = a;
+  const CensusEntry* y = b;
+  if(x->hash != y->hash)
+    return x->hash < y->hash ? -1 : 1;
+  return x->soup < y->soup ? -1 : x->soup > y->soup;
+}
+
+/*
+  One entry per shape, with the first soup it came from
+*/
+static int soup_merge(CensusEntry* entries, int count){
+  qsort(entries, count, sizeof(CensusEntry), compare_hash);
+  int size = 0;
+  for(int i = 0; i < count; i++){
+    if(size && entries[size - 1].hash == entries[i].hash){
+      entries[size - 1].count += entries[i].count;
+      continue;
+    }
+    entries[size++] = entries[i];
+  }
+  return size;
+}
+
+static void soup_range(void* arg){
+  SoupRange* r = arg;
+  SoupBatch s = {};
+  soup_init(&s, r->mode, r->size);
+  Grid grid = {};
+  grid_init(&grid, r->mode, r->size, r->size);
+
+  for(long batch = r->from; batch < r->to; batch++){
+    long first = batch * SOUP_LANES;
+    int lanes = r->soups - first < SOUP_LANES ? r->soups - first : SOUP_LANES;
+    uint64_t all = lanes < SOUP_LANES ? (1ull << lanes) - 1 : ~0ull;
+    soup_seed(&s, r->seed, batch, lanes);
+
+    uint64_t changed = all;
+    int g = 0;
+    while(g < r->generations && (changed & all)){
+      changed = soup_step(&s, &r->expr);
+      // the first step is compared against the empty buffer
+      if(++g == 1)
+        changed = all;
+    }
+    r->settled += popcount(~changed & all);
+
+    for(int lane = 0; lane < lanes; lane++){
+      for(int i = 0; i < r->size; i++)
+        for(int j = 0; j < r->size; j++)
+          grid.data[i * r->size + j].state = (s.data[soup_index(&s, i, j)] >> lane) & 1;
+
+      Census c = {};
+      census_run(grid, NULL, &c);
+      for(int e = 0; e < c.size; e++){
+        c.entries[e].soup = first + lane;
+        soup_add(r, c.entries[e]);
+      }
+      census_destroy(&c);
+    }
+    if(r->count > 4096)
+      r->count = soup_merge(r->entries, r->count);
+  }
+
+  r->count = soup_merge(r->entries, r->count);
+  free(grid.data);
+  soup_destroy(&s);
+}
+
+/*
+  Census of `soups` soups of size x size under the rule, merged over
+  all of them, returns the number of soups which settled
+*/
+long soup_run(
+  Mode mode,
+  Rule rule,
+  long soups,
+  int size,
+  int generations,
+  uint64_t seed,
+  Pool* pool,
+  Census* out){
+    long batches = (soups + SOUP_LANES - 1) / SOUP_LANES;
+    long count = (long)pool->threads * SOUP_RANGES;
+    if(count > batches)
+      count = batches;
+
+    SoupRange* ranges = calloc(sizeof(SoupRange), count + 1);
+    for(long i = 0; i < count; i++){
+      ranges[i] = (SoupRange){
+        .mode = mode,
+        .size = size,
+        .generations = generations,
+        .seed = seed,
+        .soups = soups,
+        .from = batches * i / count,
+        .to = batches * (i + 1) / count
+      };
+      rule_compile(rule, neighbors_max(mode), &ranges[i].expr);
+      pool_push(pool, soup_range, &ranges[i]);
+    }
+    pool_wait(pool);
+
+    *out = (Census){};
+    long settled = 0, total = 0;
+    for(long i = 0; i < count; i++)
+      total += ranges[i].count;
+    out->entries = malloc(sizeof(CensusEntry) * (total + 1));
+    for(long i = 0; i < count; i++){
+      memcpy(out->entries + out->size, ranges[i].entries, sizeof(CensusEntry) * ranges[i].count);
+      out->size += ranges[i].count;
+      settled += ranges[i].settled;
+      free(ranges[i].entries);
+    }
+    free(ranges);
+
+    out->size = soup_merge(out->entries, out->size);
+    for(int i = 0; i < out->size; i++)
+      out->objects += out->entries[i].count;
+    qsort(out->entries, out->size, sizeof(CensusEntry), census_compare);
+    return settled;
+}
+
+/*
+  Headless soup search, census file per rule
+
+    ./build/program soups [trigon|tetragon|hexagon] [soups] [size] [generations] [u,o,r ...]
+
+  writes soups_<mode>_<u>-<o>-<r>.txt, GOL_SEED picks another series of
+  soups (default - 1)
+*/
+void soup_search(
+  Mode mode,
+  long soups,
+  int size,
+  int generations,
+  const Rule* rules,
+  const char** names,
+  int count){
+    const char* mode_names[] = { "trigon", "tetragon", "hexagon" };
+    char* forced = getenv("GOL_SEED");
+    uint64_t seed = forced ? strtoull(forced, NULL, 10) : 1;
+    Pool* pool = pool_shared();
+
+    for(int i = 0; i < count; i++){
+      Census census = {};
+      double start = now_ms();
+      long settled = soup_run(mode, rules[i], soups, size, generations, seed, pool, &census);
+      double elapsed = now_ms() - start;
+
+      char path[64];
+      snprintf(path, sizeof(path), "soups_%s_%s.txt", mode_names[mode], names[i]);
+      FILE* out = fopen(path, "w");
+      if(!out){
+        printf("can not write %s\n", path);
+        census_destroy(&census);
+        continue;
+      }
+      fprintf(out, "# %s, rule %s, %ld soups of %dx%d, seed %llu, %d generations at most\n",
+        mode_names[mode], names[i], soups, size, size, (unsigned long long)seed, generations);
+      fprintf(out, "# %ld settled\n", settled);
+      fprintf(out, "%-18s %6s %10s %12s\n", "shape", "cells", "count", "first soup");
+      for(int e = 0; e < census.size; e++)
+        fprintf(out, "%016llx   %6d %10ld %12ld\n",
+          (unsigned long long)census.entries[e].hash,
+          census.entries[e].cells,
+          census.entries[e].count,
+          census.entries[e].soup);
+      fclose(out);
+
+      printf("%s: %ld soups, %ld settled, %ld objects, %d shapes in %.0f ms (%.0f soups/s)\n",
+        path, soups, settled, census.objects, census.size, elapsed, soups / elapsed * 1000.0);
+      census_destroy(&census);
+    }
+}
@@ -0,0 +1,52 @@
+#include "utils.h"
+
+/*
+  Statistics - population, births, deaths and bounding box per generation
+
+  They are by-products of the step, kernels fill a Tally of the flips
+  they have made anyway:
+  - bitboard kernels diff every stepped row against the previous one
+    (see bitboard_tally_row()), so births and deaths are popcounts of the
+    changed words and the box of alive cells is exact - all rows pass
+  - flip list kernels (frontier, counts) only see the flips, so the box
+    grows by the born cells and is scanned again (within the old box)
+    only when a cell died on its edge
+  Wavefront tiles tally on their own and are merged after the run, so
+  there is nothing shared between the threads.
+
+  Population is carried from generation to generation by births - deaths,
+  engine keeps the series of the last STATS_HISTORY generations in a ring.
+*/
+
+void box_merge(Box* b, Box other){
+  if(other.top > other.bottom)
+    return;
+  box_add(b, other.top, other.left);
+  box_add(b, other.bottom, other.right);
+}
+
+void tally_merge(Tally* t, Tally other){
+  t->hash ^= other.hash;
+  t->births += other.births;
+  t->deaths += other.deaths;
+  box_merge(&t->alive, other.alive);
+  box_merge(&t->born, other.born);
+  box_merge(&t->died, other.died);
+}
+
+void stats_push(StatsRing* r, Stats s){
+  r->data[r->head] = s;
+  r->head = (r->head + 1) % STATS_HISTORY;
+  if(r->size < STATS_HISTORY)
+    r->size++;
+}
+
+/*
+  Last `max` generations, oldest first, returns how many were written
+*/
+int stats_history(StatsRing* r, Stats* out, int max){
+  int size = max < r->size ? max : r->size;
+  for(int i = 0; i < size; i++)
+    out[i] = r->data[(r->head - size + i + STATS_HISTORY) % STATS_HISTORY];
+  return size;
+}
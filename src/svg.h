@@ -19,6 +19,8 @@
     More like an exercise
   */
 
+#define GROUP_CHILDREN 8   // paths of a group
+
 typedef struct{
   char name[16];
   char value[1024];
@@ -48,13 +50,13 @@ typedef struct{
 
 typedef struct{
   char name[16];
-  Path children[4];
+  Path children[GROUP_CHILDREN];
 } Group;
 
 void print_group(Group g){
   printf("\n");
   printf("%s:\n", g.name);
-  for (int i = 0; i < 4; i++)
+  for (int i = 0; i < GROUP_CHILDREN; i++)
     if(strlen(g.children[i].name))
       printf("\t%s: \t%s\n", g.children[i].name, g.children[i].value);
     else 
@@ -222,7 +224,7 @@ Group parse_group(char *paths, char *group_attrs){
   parse_attribute(&group, NULL, &group_attrs);
 
   char* token = NULL;
-  for(int i=0; i<4; i++){
+  for(int i=0; i<GROUP_CHILDREN; i++){
     strtok_(&token, &paths, '<', (Search_Until){
       .data = { "\n", " ", ">" }, 
       .size = 3});
@@ -0,0 +1,181 @@
+#include "utils.h"
+
+/*
+  Parameter sweep - every rule with every seed, headless, on the pool
+
+  Job is one (rule, seed) pair: a random soup of the seed (half of the
+  cells alive, see random.c) runs until it settles
+  into a cycle or for `generations`. Recorded per job:
+  - population at the end
+  - period of the cycle (0 - did not settle)
+  - settled_at - first generation of the cycle (-1 - did not settle)
+  - time of the run
+
+  Jobs are cut into ranges, a range keeps one engine for all of its
+  jobs (engine_random() refills its buffers, the rule expression
+  is compiled again only when the rule changes). Engines are of the
+  fastest serial kernel for the size (see tune.c), kernels of plain
+  rules step the same states. Results are written by job index, so the
+  table is the same whatever the number of threads.
+*/
+
+#define SWEEP_RANGES 4   // ranges of jobs per thread
+#define SWEEP_PERIOD 64  // longest cycle looked for
+
+typedef struct{
+  int u;
+  int o;
+  int r;
+  uint64_t seed;
+  int generations;      // done
+  long population;
+  int period;
+  int settled_at;
+  double ms;
+} SweepResult;
+
+typedef struct{
+  Mode mode;
+  int size;
+  int generations;
+  const int (*rules)[3];
+  const uint64_t* seeds;
+  int seed_count;
+  Tuning tuning;        // kernel of the engines
+  SweepResult* results;
+  long from;            // jobs [from, to)
+  long to;
+} SweepRange;
+
+static void sweep_range(void* arg){
+  SweepRange* s = arg;
+  Grid grid = {};
+  grid_init(&grid, s->mode, s->size, s->size);
+  Engine e = {};
+  if(!tune_engine(&e, s->tuning, grid))
+    engine_init(&e, BITBOARD, grid);
+  engine_detect(&e, SWEEP_PERIOD);
+  engine_track(&e, 1);
+
+  for(long job = s->from; job < s->to; job++){
+    const int* uor = s->rules[job / s->seed_count];
+    uint64_t seed = s->seeds[job % s->seed_count];
+
+    double start = now_ms();
+    engine_random(&e, seed, 0.5, NULL);
+    int done = engine_run(&e, rule_from_uor(uor[0], uor[1], uor[2]), s->generations);
+    s->results[job] = (SweepResult){
+      .u = uor[0], .o = uor[1], .r = uor[2],
+      .seed = seed,
+      .generations = done,
+      .population = engine_stats(&e).population,
+      .period = e.cycle.period,
+      .settled_at = e.cycle.period ? done - e.cycle.period : -1,
+      .ms = now_ms() - start
+    };
+  }
+
+  engine_destroy(&e);
+  free(grid.data);
+}
+
+/*
+  Rules as (u, o, r) times seeds, CSV table to `out`
+*/
+void sweep_run(
+  Mode mode,
+  int size,
+  int generations,
+  const int (*rules)[3],
+  int rule_count,
+  const uint64_t* seeds,
+  int seed_count,
+  Pool* pool,
+  FILE* out){
+    const char* mode_names[] = { "trigon", "tetragon", "hexagon" };
+    long jobs = (long)rule_count * seed_count;
+    long count = (long)pool->threads * SWEEP_RANGES;
+    if(count > jobs)
+      count = jobs;
+
+    Tuning tuning = tune_serial(mode, size, size, BITBOARD);
+    SweepResult* results = calloc(sizeof(SweepResult), jobs + 1);
+    SweepRange* ranges = calloc(sizeof(SweepRange), count + 1);
+    for(long i = 0; i < count; i++){
+      ranges[i] = (SweepRange){
+        .mode = mode,
+        .size = size,
+        .generations = generations,
+        .rules = rules,
+        .seeds = seeds,
+        .seed_count = seed_count,
+        .tuning = tuning,
+        .results = results,
+        .from = jobs * i / count,
+        .to = jobs * (i + 1) / count
+      };
+      pool_push(pool, sweep_range, &ranges[i]);
+    }
+    pool_wait(pool);
+    free(ranges);
+
+    fprintf(out, "mode,size,u,o,r,seed,generations,population,period,settled_at,ms\n");
+    for(long job = 0; job < jobs; job++){
+      SweepResult* r = &results[job];
+      fprintf(out, "%s,%d,%d,%d,%d,%llu,%d,%ld,%d,%d,%.3f\n",
+        mode_names[mode], size, r->u, r->o, r->r,
+        (unsigned long long)r->seed,
+        r->generations, r->population, r->period, r->settled_at, r->ms);
+    }
+    free(results);
+}
+
+/*
+  Headless sweep
+
+    ./build/program sweep [trigon|tetragon|hexagon] [size] [generations] [seeds] [out.csv] [u,o,r ...]
+
+  without rules every 1 <= u <= o <= max, 1 <= r <= max of the mode is
+  swept, seeds are 1..seeds, the table goes to stdout without a file
+*/
+void sweep(
+  Mode mode,
+  int size,
+  int generations,
+  int seed_count,
+  const char* path,
+  const int (*rules)[3],
+  int rule_count){
+    int max = neighbors_max(mode);
+    int (*all)[3] = NULL;
+    if(!rule_count){
+      all = malloc(sizeof(int[3]) * max * max * max);
+      for(int u = 1; u <= max; u++)
+        for(int o = u; o <= max; o++)
+          for(int r = 1; r <= max; r++){
+            all[rule_count][0] = u;
+            all[rule_count][1] = o;
+            all[rule_count++][2] = r;
+          }
+      rules = (const int (*)[3])all;
+    }
+
+    uint64_t* seeds = malloc(sizeof(uint64_t) * (seed_count + 1));
+    for(int i = 0; i < seed_count; i++)
+      seeds[i] = i + 1;
+
+    FILE* out = path ? fopen(path, "w") : stdout;
+    if(!out){
+      printf("can not write %s\n", path);
+    } else {
+      double start = now_ms();
+      sweep_run(mode, size, generations, rules, rule_count, seeds, seed_count, pool_shared(), out);
+      if(path){
+        fclose(out);
+        printf("%s: %d rules x %d seeds in %.0f ms\n",
+          path, rule_count, seed_count, now_ms() - start);
+      }
+    }
+    free(seeds);
+    free(all);
+}
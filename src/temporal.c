@@ -0,0 +1,106 @@
+#include "utils.h"
+
+/*
+  Temporal blocking - several generations per pass over the grid
+
+  Plain stepping streams the whole bitboard through memory every
+  generation. Here `depth` generations are advanced in one pass, with
+  generations skewed in time: row r of generation s needs only rows
+  r - 1 .. r + 1 of generation s - 1, so generation s can trail
+  generation s - 1 by one row:
+
+      iteration i:   gen 1 - row i
+                     gen 2 - row i - 1
+                     ...
+                     gen depth - row i - depth + 1  -> written back
+
+  Every intermediate generation keeps only 3 rows in a small ring, so
+  the whole working set is about 3 * depth rows and stays in cache,
+  grid itself is read and written once per `depth` generations.
+  Rows are never cut, so there is no halo and no recomputation for any
+  mode, even for the trigon neighborhood which reaches 2 columns.
+
+  Pass tells `stream` of the bitboard (if any) which rows of the grid it
+  has read and written so far, so that storage out of memory can fetch
+  rows ahead and release them behind (see mapped.c).
+
+  Depth is picked by the cache budget for rings of the row width:
+  trigon rows are about twice as expensive to step as square or hexagon
+  ones, so its pass is less memory bound and it gets half of the depth.
+*/
+
+#define TEMPORAL_BUDGET (256 * 1024)   // bytes for the rings
+#define TEMPORAL_DEPTH_MAX 16
+
+int temporal_depth(Mode mode, int words){
+  int depth = TEMPORAL_BUDGET / (3 * (words + 2) * (int)sizeof(uint64_t));
+  if(mode == TRIGON)
+    depth /= 2;
+  if(depth > TEMPORAL_DEPTH_MAX)
+    depth = TEMPORAL_DEPTH_MAX;
+  return depth;
+}
+
+void bitboard_run(Bitboard* b, Rule rule, int generations){
+  bitboard_rule(b, rule);
+
+  int depth = b->depth ? b->depth : temporal_depth(b->mode, b->words);
+  if(depth < 2){
+    for(int g = 0; g < generations; g++)
+      bitboard_step(b, rule);
+    return;
+  }
+
+  // ring of generation s (1 .. depth - 1) holds row r in slot r % 3,
+  // one more zero row is for reads outside of the grid
+  int stride = b->stride;
+  uint64_t* rings = calloc(sizeof(uint64_t), stride * (3 * depth + 1));
+  uint64_t* zero = rings + 3 * depth * stride;
+
+  for(int done = 0; done < generations; done += depth){
+    int k = generations - done < depth ? generations - done : depth;
+    Tally inner = tally_empty(), last = tally_empty();
+
+    for(int i = 0; i < b->rows + k - 1; i++){
+      // rows of the grid above i - 1 are read, above i - k + 1 written
+      if(b->stream)
+        b->stream(b->stream_arg, i - 1, i - k + 1);
+      for(int s = 1; s <= k; s++){
+        int row = i - s + 1;
+        if(row < 0 || row >= b->rows)
+          continue;
+
+        uint64_t* out = s == k
+          ? b->next + (bitboard_row(b, row) - b->data)
+          : rings + (3 * s + row % 3) * stride + 1;
+
+        // rows of the previous generation, from the grid or from its ring
+        const uint64_t* window[3];
+        for(int d = -1; d <= 1; d++)
+          window[d + 1] = s == 1
+            ? bitboard_row(b, row + d)
+            : row + d < 0 || row + d >= b->rows
+              ? zero + 1
+              : rings + (3 * (s - 1) + (row + d) % 3) * stride + 1;
+        bitboard_step_row(b, window, out, 0, b->words, row, b->generation + s - 1);
+        out[b->words - 1] &= b->tail;
+        if(b->hashing || b->tracking)
+          bitboard_tally_row(b, window[1], out, 0, b->words, row, s == k ? &last : &inner);
+      }
+    }
+    if(b->stream)
+      b->stream(b->stream_arg, b->rows, b->rows);
+
+    // statistics are only of the last generation of the pass
+    b->hash ^= inner.hash ^ last.hash;
+    b->tally = last;
+    b->tally.scanned = 1;
+    b->generation += k;
+
+    uint64_t* tmp = b->data;
+    b->data = b->next;
+    b->next = tmp;
+  }
+
+  free(rings);
+}
@@ -0,0 +1,252 @@
+#include "utils.h"
+
+/*
+  Autotuner - the fastest kernel and its tunables on this machine
+
+  Kernels stepping plain rules give the same states, which one is the
+  fastest depends on the caches, the cores and the grid size. Every
+  candidate - kernel, temporal depth (BLOCKED), tile and threads of the
+  shared pool (WAVEFRONT) - steps the same random soup for
+  TUNE_GENERATIONS, the best of TUNE_REPEATS runs counts, and the
+  fastest one is kept per (mode, size class): grids of about the same
+  number of cells, side ~ 2^class. Soup is at most TUNE_SIDE a side,
+  bigger grids are timed on that.
+
+  Serial choices are for engines stepped by pool tasks themselves
+  (sweep.c), they can not wait for the pool, so WAVEFRONT is left out.
+
+  Choices are cached in a text file (GOL_TUNE_CACHE, default
+  build/tune.cache), a line per choice keyed by the CPU model and the
+  threads the pool may use (or serial), so the cache of another machine
+  does not count. GOL_TUNE=0 skips tuning - the fallback kernel is used
+  with the default tunables.
+*/
+
+#define TUNE_GENERATIONS 16
+#define TUNE_REPEATS 3
+#define TUNE_SIDE 2048
+#define TUNE_CANDIDATES 64
+#define TUNE_CPU 128
+
+static const char* tune_mode_names[] = { "trigon", "tetragon", "hexagon" };
+
+/*
+  Grids of 4^class cells or a bit less
+*/
+int tune_class(int rows, int cols){
+  long cells = (long)rows * cols;
+  int bits = cells > 1 ? 64 - __builtin_clzll(cells - 1) : 0;
+  return (bits + 1) / 2;
+}
+
+/*
+  CPU model and the threads of the pool, the key of the cache lines
+*/
+static void tune_cpu(char* out, int size, int serial){
+  char model[TUNE_CPU] = "unknown";
+  FILE* f = fopen("/proc/cpuinfo", "r");
+  if(f){
+    char line[256];
+    while(fgets(line, sizeof(line), f)){
+      char* value = strchr(line, ':');
+      if(strncmp(line, "model name", 10) || !value)
+        continue;
+      value += 1 + (value[1] == ' ');
+      value[strcspn(value, "\n")] = '\0';
+      snprintf(model, sizeof(model), "%s", value);
+      break;
+    }
+    fclose(f);
+  }
+  if(serial)
+    snprintf(out, size, "%s, serial", model);
+  else
+    snprintf(out, size, "%s, %d threads", model, pool_threads_default());
+}
+
+static const char* tune_cache_path(){
+  char* path = getenv("GOL_TUNE_CACHE");
+  return path ? path : "build/tune.cache";
+}
+
+/*
+  Cached choice for the mode, class and cpu, later lines win
+*/
+static int tune_cached(Mode mode, int class, const char* cpu, Tuning* out){
+  FILE* f = fopen(tune_cache_path(), "r");
+  if(!f)
+    return 0;
+  int found = 0;
+  char line[512];
+  while(fgets(line, sizeof(line), f)){
+    char mode_name[16], kernel[16];
+    int line_class, end = 0;
+    Tuning t = {};
+    if(sscanf(line, "%15s %d %15s %d %d %d %d %lf %n",
+        mode_name, &line_class, kernel, &t.depth, &t.tile_rows, &t.tile_words,
+        &t.threads, &t.ms, &end) != 8 || !end)
+      continue;
+    line[strcspn(line, "\n")] = '\0';
+    if(strcmp(mode_name, tune_mode_names[mode]) || line_class != class
+        || strcmp(line + end, cpu) || !kernel_from_name(kernel, &t.kernel))
+      continue;
+    *out = t;
+    found = 1;
+  }
+  fclose(f);
+  return found;
+}
+
+static void tune_store(Mode mode, int class, const char* cpu, Tuning t){
+  FILE* f = fopen(tune_cache_path(), "a");
+  if(!f)
+    return;
+  fprintf(f, "%s %d %s %d %d %d %d %.4f %s\n",
+    tune_mode_names[mode], class, kernel_name(t.kernel),
+    t.depth, t.tile_rows, t.tile_words, t.threads, t.ms, cpu);
+  fclose(f);
+}
+
+/*
+  Engine of the kernel with the tunables of the choice, the shared pool
+  gets its threads
+*/
+int tune_engine(Engine* e, Tuning t, Grid grid){
+  if(!engine_init(e, t.kernel, grid))
+    return 0;
+  e->board.depth = t.depth;
+  e->board.tile_rows = t.tile_rows;
+  e->board.tile_words = t.tile_words;
+  if(t.threads)
+    pool_shared_threads(t.threads);
+  return 1;
+}
+
+static int tune_candidates(Tuning out[TUNE_CANDIDATES], int serial){
+  int size = 0;
+  const Kernel plain[] = { BITBOARD, LUT, FRONTIER, COUNTS };
+  for(int k = 0; k < 4; k++)
+    out[size++] = (Tuning){ .kernel = plain[k] };
+
+  const int depths[] = { 0, 2, 4, 8, 16 };
+  for(int d = 0; d < 5; d++)
+    out[size++] = (Tuning){ .kernel = BLOCKED, .depth = depths[d] };
+
+  if(serial)
+    return size;
+
+  // threads 1, 2, 4 .. and all of them
+  const int tiles[][2] = { { 16, 2 }, { 32, 4 }, { 64, 4 }, { 64, 8 }, { 128, 16 } };
+  int cores = pool_threads_default();
+  for(int threads = 1; threads <= cores;
+      threads = threads < cores && threads * 2 > cores ? cores : threads * 2)
+    for(int k = 0; k < 5 && size < TUNE_CANDIDATES; k++)
+      out[size++] = (Tuning){
+        .kernel = WAVEFRONT,
+        .tile_rows = tiles[k][0],
+        .tile_words = tiles[k][1],
+        .threads = threads
+      };
+  return size;
+}
+
+/*
+  ms per generation of the candidate on the soup, the best of the runs,
+  < 0 - kernel does not step the mode
+*/
+static double tune_measure(Tuning t, Grid grid, Rule rule){
+  Engine e = {};
+  if(!tune_engine(&e, t, grid))
+    return -1;
+  engine_random(&e, 1, 0.3, pool_shared());
+  engine_run(&e, rule, 1);   // warm up, rule tables are built here
+  double ms = -1;
+  for(int k = 0; k < TUNE_REPEATS; k++){
+    double start = now_ms();
+    engine_run(&e, rule, TUNE_GENERATIONS);
+    double run = (now_ms() - start) / TUNE_GENERATIONS;
+    if(ms < 0 || run < ms)
+      ms = run;
+  }
+  engine_destroy(&e);
+  return ms;
+}
+
+/*
+  Times every candidate (serial ones only with `serial`), prints them to
+  `log` if given
+*/
+Tuning tune_calibrate(Mode mode, int rows, int cols, int serial, FILE* log){
+  Grid grid = {};
+  grid_init(&grid, mode, rows < TUNE_SIDE ? rows : TUNE_SIDE, cols < TUNE_SIDE ? cols : TUNE_SIDE);
+  Rule rule = rule_from_uor(2, 3, 3);
+
+  Tuning candidates[TUNE_CANDIDATES];
+  int size = tune_candidates(candidates, serial);
+  Tuning best = { .kernel = BITBOARD, .ms = -1 };
+  for(int i = 0; i < size; i++){
+    Tuning t = candidates[i];
+    t.ms = tune_measure(t, grid, rule);
+    if(t.ms < 0)
+      continue;
+    if(log)
+      fprintf(log, "%-9s depth %2d tile %3dx%-2d threads %2d: %8.3f ms/gen\n",
+        kernel_name(t.kernel), t.depth, t.tile_rows, t.tile_words, t.threads, t.ms);
+    if(best.ms < 0 || t.ms < best.ms)
+      best = t;
+  }
+  // back to the default pool, tune_engine() sets the chosen one
+  pool_shared_threads(0);
+  free(grid.data);
+  return best;
+}
+
+static Tuning tune_choice(Mode mode, int rows, int cols, Kernel fallback, int serial){
+  char* skip = getenv("GOL_TUNE");
+  if(skip && !strcmp(skip, "0"))
+    return (Tuning){ .kernel = fallback };
+
+  char cpu[TUNE_CPU + 32];
+  tune_cpu(cpu, sizeof(cpu), serial);
+  int class = tune_class(rows, cols);
+  Tuning t = {};
+  if(tune_cached(mode, class, cpu, &t))
+    return t;
+
+  t = tune_calibrate(mode, rows, cols, serial, NULL);
+  tune_store(mode, class, cpu, t);
+  return t;
+}
+
+/*
+  Choice for the grid, from the cache or calibrated and cached,
+  `fallback` with the defaults when GOL_TUNE=0
+*/
+Tuning tune(Mode mode, int rows, int cols, Kernel fallback){
+  return tune_choice(mode, rows, cols, fallback, 0);
+}
+
+/*
+  Choice for engines stepped by pool tasks, see tune()
+*/
+Tuning tune_serial(Mode mode, int rows, int cols, Kernel fallback){
+  return tune_choice(mode, rows, cols, fallback, 1);
+}
+
+/*
+  Headless calibration of both choices, every candidate printed, the
+  choices cached for the headless commands
+
+    ./build/program tune [trigon|tetragon|hexagon] [size]
+*/
+void tune_world(Mode mode, int size){
+  char cpu[TUNE_CPU + 32];
+  int class = tune_class(size, size);
+  for(int serial = 0; serial < 2; serial++){
+    printf("%s:\n", serial ? "serial, for pool tasks" : "on the shared pool");
+    Tuning t = tune_calibrate(mode, size, size, serial, stdout);
+    tune_cpu(cpu, sizeof(cpu), serial);
+    tune_store(mode, class, cpu, t);
+    printf("fastest for size class %d: %s\n", class, kernel_name(t.kernel));
+  }
+}
@@ -5,6 +5,10 @@
 #include <cglm/cglm.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <pthread.h>
 
 #ifndef UTILS_H
 #define UTILS_H
@@ -47,6 +51,354 @@ typedef struct{
   int generation;
 } Grid;
 
+typedef enum {
+  CELLS,      // neighbors_alive() over Cell instances
+  PLANE,      // byte per cell, axial for hexagon
+  BITBOARD,   // bit per cell, bit-sliced
+  LUT,        // bit per cell, 2x2 blocks by lookup table (tetragon)
+  BLOCKED,    // bitboard, several generations per pass over the grid
+  WAVEFRONT,  // bitboard, tiles of several generations on the thread pool
+  FRONTIER,   // bitboard, only cells next to the last changes
+  COUNTS,     // byte per cell with its neighbor count, updated by flips
+  GENERATIONS,// bitboard of alive cells and bit planes of decaying ones
+  ISOTROPIC,  // bitboard, 3x3 neighborhoods by lookup table (tetragon)
+  GRAPH,      // byte per cell, CSR adjacency of the tiling from tilings.svg
+  LTL,        // byte per cell, radius R counts from prefix sums
+  LENIA,      // float per cell, continuous growth by FFT convolution
+  MARGOLUS    // bitboard, 2x2 blocks of alternating cuts by block rule (tetragon)
+} Kernel;
+
+typedef struct{
+  unsigned short birth;    // bit n - dead cell with n alive neighbors is born
+  unsigned short survive;  // bit n - alive cell with n alive neighbors lives on
+  unsigned char states;    // Generations: dead, alive and states - 2 decaying,
+                           // 0 / 2 - life (only GENERATIONS kernel decays)
+  unsigned char radius;    // Larger than Life: neighborhood radius with the
+                           // ranges below, 0 - the masks above (only LTL
+                           // kernel reaches further than 1)
+  unsigned char middle;    // Larger than Life: the cell counts itself
+  unsigned short births[2];     // born with n in [births[0], births[1]]
+  unsigned short survivals[2];  // lives on with n in the range
+  float mu;                // Lenia: growth peaks at this potential
+  float sigma;             // Lenia: growth width, 0 - not a continuous rule
+  float dt;                // Lenia: time step
+  unsigned char isotropic; // non-totalistic, next states are in neighborhoods
+  uint64_t neighborhoods[8];  // bit k - next state of the 3x3 neighborhood k
+                              // (see rule_from_hensel())
+  unsigned char stochastic;  // births and survivals of the masks happen by
+                             // chance (only bitboard kernels draw)
+  float birth_chance;      // stochastic: of a birth
+  float survive_chance;    // stochastic: of a survival
+  uint64_t seed;           // stochastic: stream of the draws, keyed by
+                           // (seed, generation, cell)
+  unsigned char margolus;  // block rule, next 2x2 blocks are in blocks
+  unsigned char blocks[16];  // next of the block, bits 0 1 / 2 3 (only
+                             // MARGOLUS kernel steps blocks)
+} Rule;
+
+#define DECAY_PLANES 3     // most bit planes of the decay counter (Generations)
+#define DECAY_STATES (1 + (1 << DECAY_PLANES))   // most states they hold
+
+#define RULE_BITS 4        // neighbor count bit planes, up to 15 neighbors
+#define RULE_VARS (RULE_BITS + 1)   // count bit planes and the state
+#define RULE_TERMS 32
+
+typedef struct{
+  int size;
+  uint64_t inv[RULE_TERMS][RULE_VARS];
+  uint64_t dc[RULE_TERMS][RULE_VARS];
+} RuleExpr;
+
+typedef struct{
+  int top;
+  int left;
+  int bottom;
+  int right;            // inclusive, empty box has top > bottom
+} Box;
+
+typedef struct{
+  uint64_t hash;        // hash change by the flips
+  long births;
+  long deaths;
+  int scanned;          // all rows were scanned, `alive` is exact
+  Box alive;            // alive cells of the scanned rows
+  Box born;             // cells born in the step
+  Box died;             // cells died in the step
+} Tally;
+
+typedef struct{
+  unsigned char* data;  // current states, with dead border
+  unsigned char* next;  // scratch for the step
+  int rows;
+  int cols;
+  int stride;           // row pitch of the storage
+  int skew;             // axial shift of the first row (hexagon)
+  Mode mode;
+  int tracking;         // tally the steps
+  Tally tally;          // of the last step
+} Plane;
+
+typedef struct{
+  uint64_t* data;       // current states, with zero border
+  uint64_t* next;       // scratch for the step
+  int rows;
+  int cols;
+  int words;            // words per row
+  int stride;           // row pitch of the storage in words
+  uint64_t tail;        // valid bits of the last word in a row
+  Mode mode;
+  Rule rule;            // rule the expression was compiled for
+  RuleExpr expr;
+  const struct CompiledKernel* kernel;   // of the rule (kernels.h), NULL -
+                                         // stepped by the expression
+  unsigned char* table; // next states by neighborhood (LUT, ISOTROPIC),
+                        // NULL - not built yet
+  Rule table_rule;      // rule the table was built for
+  unsigned chance[2];   // thresholds of birth and survival (stochastic rule)
+  int generation;       // of the states, stochastic rules draw by it
+  int depth;            // generations per pass of temporal blocking,
+                        // 0 - picked by mode and row width
+  int tile_rows;        // wavefront tiles, 0 - default
+  int tile_words;
+  int hashing;          // keep the hash while stepping
+  uint64_t hash;        // zobrist hash of the state words
+  int tracking;         // tally the steps
+  Tally tally;          // of the last step
+  uint64_t* decay[DECAY_PLANES];  // decay counter planes (GENERATIONS)
+  int decay_planes;     // of them allocated, as many as the states need
+  void (*stream)(void* arg, int read, int written);  // rows done by a pass
+                        // of bitboard_run() so far, NULL - in memory
+  void* stream_arg;
+} Bitboard;
+
+typedef struct{
+  Bitboard board;       // planes are in the mapping
+  int fd;
+  void* map;            // header page and the two planes
+  size_t size;          // bytes of the mapping
+  long budget;          // resident bytes the stepping aims at
+  int band;             // rows per tile
+  int ahead;            // rows of the pass fetched
+  int read;             // rows of the pass dropped, current plane
+  int written;          // and the next one
+  int fresh;            // file was created, not resumed
+} Mapped;
+
+typedef struct{
+  Bitboard board;       // rows of the strip, halos in the border rows
+  int rank;
+  int ranks;
+  int first;            // grid row of the first row of the strip
+  int grid_rows;
+  int up;               // socket to the rank above, -1 - grid edge
+  int down;             // to the rank below
+  int broken;           // a neighbor is gone
+} Domain;
+
+typedef struct{
+  Mode mode;
+  long offsets[2][12];  // neighbor bit offsets per parity class
+  int degree[2];
+  long* changed;        // bit positions changed in the last generation
+  int changed_size;
+  int valid;            // changes are known, otherwise full sweep
+  Rule rule;            // rule of the last generation
+  long* candidates;
+  long* flips;
+  int capacity;
+  int threshold;        // max changes for frontier stepping
+  unsigned int* stamp;  // dedup of candidates, by bit position
+  unsigned int epoch;
+} Frontier;
+
+typedef struct{
+  unsigned char* data;  // count << 1 | state, with dead border
+  int rows;
+  int cols;
+  int stride;           // row pitch of the storage
+  Mode mode;
+  long offsets[2][12];  // neighbor offsets per parity class
+  int degree[2];
+  int* flips;           // cells flipping in the step
+  uint64_t hash;        // zobrist hash of the states
+  int tracking;         // tally the steps
+  Tally tally;          // of the last step
+} Counts;
+
+typedef struct{
+  unsigned char* data;  // current states, axial for hexagon
+  unsigned char* next;  // scratch for the step
+  uint32_t* sums;       // summed-area table of the states
+  uint32_t* diagonal;   // row prefix sums summed along diagonals (hexagon)
+  uint32_t* totals;     // summed row totals (hexagon)
+  unsigned char* table; // next state by state and count
+  int table_size;       // counts per state in the table
+  int radius;           // of the last step
+  int middle;
+  int rows;
+  int cols;
+  int width;            // row pitch of the storage
+  int skew;             // axial shift of the first row (hexagon)
+  Mode mode;
+  uint64_t hash;        // zobrist hash of the states
+  int tracking;         // tally the steps
+  Tally tally;          // of the last step
+} Ltl;
+
+typedef struct{
+  double re;
+  double im;
+} Complex;
+
+typedef struct FftPlan{
+  int n;
+  Complex* twiddles;    // e^(-2 pi i k / n), power of two lengths
+  int* reverse;         // bit reversal permutation
+  Complex* chirp;       // e^(-i pi k^2 / n), other lengths (Bluestein)
+  Complex* filter;      // spectrum of conj(chirp), scaled by 1 / inner->n
+  struct FftPlan* inner;  // power of two plan of the convolution
+} FftPlan;
+
+typedef struct{
+  float* data;          // current levels 0 .. 1
+  int rows;
+  int cols;
+  int half;             // spectrum numbers of a row, cols / 2 + 1
+  FftPlan row_plan;
+  FftPlan col_plan;
+  Complex* spectrum;    // rows x half, scratch for the step
+  Complex* kernel;      // spectrum of the kernel, scaled by 1 / (rows * cols)
+  int radius;           // of the kernel spectrum, 0 - not built yet
+  int tracking;         // tally the steps
+  Tally tally;          // of the last step, level 1 cells are alive
+} Lenia;
+
+typedef struct{
+  signed char rows;     // block of the neighbor, relative to the tile's
+  signed char cols;
+  unsigned char tile;   // of the neighbor in its block
+} TilingLink;
+
+typedef struct{
+  const char* name;
+  int rows;             // tiles of the block
+  int cols;
+  float period[2][2];   // step of the block to the next column, next row
+  const unsigned char* sizes;     // vertices of the tiles
+  const float* vertices;          // x, y of the tiles, in block order
+  const unsigned short* first;    // links of tile t: first[t] .. first[t + 1]
+  const TilingLink* links;        // tiles sharing a vertex with it
+} Tiling;
+
+typedef struct{
+  const Tiling* tiling;
+  unsigned char* data;  // current states
+  unsigned char* next;  // scratch for the step
+  int* first;           // neighbors of cell i: adjacent[first[i] .. first[i + 1]]
+  int* adjacent;
+  int rows;
+  int cols;
+  struct GraphRange* ranges;  // of the pool, kept between steps
+  int ranges_size;
+  uint64_t hash;        // zobrist hash of the states
+  int tracking;         // tally the steps
+  Tally tally;          // of the last step
+} Graph;
+
+#define CYCLE_HISTORY 64
+
+typedef struct{
+  uint64_t history[CYCLE_HISTORY];  // hashes of the last generations, ring
+  int head;
+  int size;
+  int period_max;       // longest period looked for, 0 - off
+  int period;           // period of the last generation, 0 - no cycle
+} Cycle;
+
+typedef struct{
+  uint64_t hash;        // canonical, same for every placement and symmetry
+  int cells;
+  long count;           // objects of this shape
+  int row;              // top left cell of one of them
+  int col;
+  long soup;            // first soup it came from (soup search)
+} CensusEntry;
+
+typedef struct{
+  CensusEntry* entries; // most common first
+  int size;
+  long objects;
+} Census;
+
+typedef struct{
+  int generation;
+  long population;
+  long births;          // since the previous generation
+  long deaths;
+  Box box;              // bounding box of alive cells
+} Stats;
+
+#define STATS_HISTORY 1024
+
+typedef struct{
+  Stats data[STATS_HISTORY];  // ring, oldest is overwritten
+  int head;
+  int size;
+} StatsRing;
+
+typedef struct{
+  Kernel kernel;
+  Grid grid;            // states for CELLS kernel
+  Plane plane;
+  Bitboard board;       // states for all bitboard kernels
+  Frontier frontier;
+  Counts counts;
+  Ltl ltl;
+  Lenia lenia;
+  Graph graph;
+  Cycle cycle;
+  int tracking;         // stats of every generation are kept
+  Tally tally;          // of the last step of CELLS kernel
+  Stats stats;          // of the current generation
+  StatsRing history;
+} Engine;
+
+typedef struct{
+  Kernel kernel;
+  int depth;            // generations per pass (BLOCKED), 0 - default
+  int tile_rows;        // tile (WAVEFRONT), 0 - default
+  int tile_words;
+  int threads;          // of the shared pool, 0 - default
+  double ms;            // per generation in the calibration
+} Tuning;
+
+typedef struct{
+  void (*fn)(void* arg);
+  void* arg;
+} PoolTask;
+
+typedef struct{
+  PoolTask* data;       // ring, owner works at the bottom, thieves at the top
+  long top;
+  long bottom;
+  int capacity;
+  pthread_mutex_t lock;
+} Deque;
+
+typedef struct{
+  int threads;
+  pthread_t* workers;
+  Deque* deques;
+  pthread_mutex_t lock;
+  pthread_cond_t wake;  // tasks were pushed or pool is stopping
+  pthread_cond_t idle;  // all tasks are done
+  atomic_int pending;   // pushed and not finished yet
+  atomic_int queued;    // pushed and not taken yet
+  atomic_int started;
+  atomic_int next;
+  int stop;
+} Pool;
+
 GLuint create_grid_texture(
   int line_width,
   int spacing);
@@ -140,8 +492,766 @@ void game_click(
   int y,
   Mode* mode);
 
+void game_random();
+
 void game_destroy();
 
-void next_generation(char u, char o, char r);
+int next_generation(char u, char o, char r);
+
+int plane_init(
+  Plane* p,
+  Mode mode,
+  int rows,
+  int cols);
+
+void plane_destroy(Plane* p);
+
+int plane_index(
+  Plane* p,
+  int row,
+  int col);
+
+void plane_set(
+  Plane* p,
+  int row,
+  int col,
+  unsigned char value);
+
+void plane_load(Plane* p, Grid in);
+
+void plane_store(Plane* p, Grid out);
+
+void plane_step(Plane* p, Rule rule);
+
+Rule rule_from_uor(
+  char u,
+  char o,
+  char r);
+
+int rule_from_hensel(
+  const char* text,
+  Rule* out);
+
+int rule_next(Rule rule, int neighborhood);
+
+int rule_from_ltl(
+  const char* text,
+  Rule* out);
+
+Rule rule_lenia_default();
+
+int rule_from_lenia(
+  const char* text,
+  Rule* out);
+
+int rule_chance(
+  const char* text,
+  Rule* rule);
+
+void rule_compile(
+  Rule rule,
+  int max,
+  RuleExpr* out);
+
+static inline uint64_t rule_eval(
+  const RuleExpr* e,
+  const uint64_t v[RULE_VARS]){
+    uint64_t result = 0;
+    for(int t = 0; t < e->size; t++){
+      uint64_t term = ~0ull;
+      for(int k = 0; k < RULE_VARS; k++)
+        term &= (v[k] ^ e->inv[t][k]) | e->dc[t][k];
+      result |= term;
+    }
+    return result;
+}
+
+/*
+  Bit-sliced adders, every bit of the words is a separate sum
+*/
+static inline void half_add(
+  uint64_t a,
+  uint64_t b,
+  uint64_t* sum,
+  uint64_t* carry){
+    *sum = a ^ b;
+    *carry = a & b;
+}
+
+static inline void full_add(
+  uint64_t a,
+  uint64_t b,
+  uint64_t c,
+  uint64_t* sum,
+  uint64_t* carry){
+    uint64_t t = a ^ b;
+    *sum = t ^ c;
+    *carry = (a & b) | (t & c);
+}
+
+/*
+  Bit count without a libgcc call when popcnt is not enabled
+  (baseline x86-64)
+*/
+static inline int popcount(uint64_t x){
+#ifdef __POPCNT__
+  return __builtin_popcountll(x);
+#else
+  x = x - ((x >> 1) & 0x5555555555555555ull);
+  x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+  x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0full;
+  return (x * 0x0101010101010101ull) >> 56;
+#endif
+}
+
+static inline uint64_t zobrist_mix(uint64_t x){
+  x += 0x9e3779b97f4a7c15ull;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
+
+/*
+  Zobrist key of the alive cell
+*/
+static inline uint64_t zobrist_key(int row, int col){
+  return zobrist_mix((uint64_t)row << 32 | (uint32_t)col);
+}
+
+/*
+  Zobrist key of the bitboard word with its bits, zero words have none
+*/
+static inline uint64_t zobrist_word(long word, uint64_t bits){
+  return zobrist_mix(word * 0xd6e8feb86659fd93ull ^ bits) & -(uint64_t)(bits != 0);
+}
+
+/*
+  Counter based random bits - the same for the same (seed, counter) and
+  no state, so any part of a fill can be made on any thread
+*/
+static inline uint64_t counter_random(uint64_t seed, uint64_t counter){
+  return zobrist_mix(zobrist_mix(seed) ^ counter);
+}
+
+static inline Box box_empty(){
+  return (Box){ .top = INT_MAX, .left = INT_MAX, .bottom = -1, .right = -1 };
+}
+
+static inline void box_add(Box* b, int row, int col){
+  if(row < b->top) b->top = row;
+  if(row > b->bottom) b->bottom = row;
+  if(col < b->left) b->left = col;
+  if(col > b->right) b->right = col;
+}
+
+static inline Tally tally_empty(){
+  return (Tally){ .alive = box_empty(), .born = box_empty(), .died = box_empty() };
+}
+
+void box_merge(Box* b, Box other);
+
+void tally_merge(Tally* t, Tally other);
+
+void stats_push(StatsRing* r, Stats s);
+
+int stats_history(
+  StatsRing* r,
+  Stats* out,
+  int max);
+
+void cycle_init(Cycle* c, int period_max);
+
+void cycle_reset(Cycle* c);
+
+int cycle_push(Cycle* c, uint64_t hash);
+
+int bitboard_init(
+  Bitboard* b,
+  Mode mode,
+  int rows,
+  int cols);
+
+void bitboard_destroy(Bitboard* b);
+
+uint64_t* bitboard_row(Bitboard* b, int row);
+
+void bitboard_set(
+  Bitboard* b,
+  int row,
+  int col,
+  unsigned char value);
+
+unsigned char bitboard_get(
+  Bitboard* b,
+  int row,
+  int col);
+
+void bitboard_load(Bitboard* b, Grid in);
+
+void bitboard_tally_row(
+  Bitboard* b,
+  const uint64_t* was,
+  const uint64_t* now,
+  int from,
+  int to,
+  int row,
+  Tally* t);
+
+Box bitboard_box(Bitboard* b, Box within);
+
+uint64_t bitboard_hash(Bitboard* b);
+
+void bitboard_store(Bitboard* b, Grid out);
+
+void bitboard_rule(Bitboard* b, Rule rule);
+
+void bitboard_step_row(
+  Bitboard* b,
+  const uint64_t* window[3],
+  uint64_t* out,
+  int from,
+  int to,
+  int row,
+  int generation);
+
+void bitboard_step(Bitboard* b, Rule rule);
+
+int temporal_depth(Mode mode, int words);
+
+void bitboard_run(
+  Bitboard* b,
+  Rule rule,
+  int generations);
+
+int neighbors_max(Mode mode);
+
+int lut_init(
+  Bitboard* b,
+  Mode mode,
+  int rows,
+  int cols);
+
+void lut_step(Bitboard* b, Rule rule);
+
+int isotropic_init(
+  Bitboard* b,
+  Mode mode,
+  int rows,
+  int cols);
+
+void isotropic_step(Bitboard* b, Rule rule);
+
+int rule_from_blocks(
+  const char* text,
+  Rule* out);
+
+int margolus_init(
+  Bitboard* b,
+  Mode mode,
+  int rows,
+  int cols);
+
+void margolus_step(
+  Bitboard* b,
+  Pool* pool,
+  Rule rule,
+  int phase);
+
+const char* kernel_name(Kernel kernel);
+
+int kernel_from_name(
+  const char* name,
+  Kernel* out);
+
+int kernel_draws(Kernel kernel);
+
+Mode mode_from_name(const char* name);
+
+void grid_init(
+  Grid* g,
+  Mode mode,
+  int rows,
+  int cols);
+
+void neighbors_indices(
+  int row,
+  int col,
+  Grid in,
+  int out[12]);
+
+char neighbors_alive(
+  int row,
+  int col,
+  Grid in);
+
+int neighbors_class(
+  Mode mode,
+  int row,
+  int col);
+
+void neighbors_steps(
+  Mode mode,
+  int out[2][12][2],
+  int degree[2]);
+
+void neighbors_offsets(
+  Mode mode,
+  long stride,
+  long out[2][12],
+  int degree[2]);
+
+int engine_init(
+  Engine* e,
+  Kernel kernel,
+  Grid grid);
+
+void engine_destroy(Engine* e);
+
+void engine_random(
+  Engine* e,
+  uint64_t seed,
+  double density,
+  Pool* pool);
+
+void engine_set(
+  Engine* e,
+  int row,
+  int col,
+  unsigned char value);
+
+float engine_state(
+  Engine* e,
+  int row,
+  int col);
+
+void engine_load(Engine* e, Grid in);
+
+void engine_store(Engine* e, Grid out);
+
+void engine_step(Engine* e, Rule rule);
+
+uint64_t engine_hash(Engine* e);
+
+void engine_detect(Engine* e, int period_max);
+
+void engine_track(Engine* e, int on);
+
+Stats engine_stats(Engine* e);
+
+int engine_history(
+  Engine* e,
+  Stats* out,
+  int max);
+
+int pool_threads_default();
+
+void pool_init(Pool* p, int threads);
+
+void pool_destroy(Pool* p);
+
+void pool_push(
+  Pool* p,
+  void (*fn)(void* arg),
+  void* arg);
+
+void pool_wait(Pool* p);
+
+Pool* pool_shared();
+
+void pool_shared_threads(int threads);
+
+void frontier_init(Frontier* f, Bitboard* b);
+
+void frontier_destroy(Frontier* f);
+
+void frontier_mark(
+  Frontier* f,
+  Bitboard* b,
+  int row,
+  int col);
+
+void frontier_step(
+  Frontier* f,
+  Bitboard* b,
+  Rule rule);
+
+int counts_init(
+  Counts* c,
+  Mode mode,
+  int rows,
+  int cols);
+
+void counts_destroy(Counts* c);
+
+void counts_set(
+  Counts* c,
+  int row,
+  int col,
+  unsigned char value);
+
+float counts_state(
+  Counts* c,
+  int row,
+  int col);
+
+void counts_load(Counts* c, Grid in);
+
+void counts_store(Counts* c, Grid out);
+
+void counts_step(Counts* c, Rule rule);
+
+Box counts_box(Counts* c, Box within);
+
+int census_run(
+  Grid g,
+  Pool* pool,
+  Census* out);
+
+void census_destroy(Census* c);
+
+int census_compare(
+  const void* a,
+  const void* b);
+
+void census_print(Census* c, FILE* out);
+
+void census_soup(
+  Mode mode,
+  int size,
+  int generations);
+
+unsigned random_threshold(double density);
+
+uint64_t random_chance(
+  uint64_t seed,
+  uint64_t word,
+  uint64_t lanes,
+  const unsigned threshold[2]);
+
+void grid_random(
+  Grid g,
+  uint64_t seed,
+  double density);
+
+long bitboard_random(
+  Bitboard* b,
+  uint64_t seed,
+  double density,
+  Pool* pool);
+
+long bitboard_random_rows(
+  Bitboard* b,
+  uint64_t seed,
+  double density,
+  int from,
+  int to,
+  int first);
+
+int mapped_init(
+  Mapped* m,
+  const char* path,
+  Mode mode,
+  int rows,
+  int cols,
+  long budget,
+  int recreate);
+
+void mapped_destroy(Mapped* m);
+
+long mapped_random(
+  Mapped* m,
+  uint64_t seed,
+  double density);
+
+long mapped_population(Mapped* m);
+
+void mapped_run(
+  Mapped* m,
+  Rule rule,
+  int generations);
+
+void mapped_world(
+  Mode mode,
+  int size,
+  int generations,
+  const char* path,
+  long budget);
+
+int domain_init(
+  Domain* d,
+  Mode mode,
+  int rows,
+  int cols,
+  int rank,
+  int ranks,
+  int up,
+  int down);
+
+void domain_destroy(Domain* d);
+
+long domain_random(
+  Domain* d,
+  uint64_t seed,
+  double density);
+
+int domain_step(
+  Domain* d,
+  Pool* pool,
+  Rule rule);
+
+long domain_sum(Domain* d, long value);
+
+long domain_population(Domain* d);
+
+int domain_spawn(
+  int ranks,
+  int* up,
+  int* down);
+
+void domain_join(int rank);
+
+int domain_connect(
+  const char* nodes,
+  int rank,
+  int* up,
+  int* down);
+
+void domain_world(
+  Mode mode,
+  int size,
+  int generations,
+  int ranks);
+
+void generations_init(Bitboard* b);
+
+void generations_destroy(Bitboard* b);
+
+void generations_clear(Bitboard* b);
+
+int generations_get(
+  Bitboard* b,
+  int row,
+  int col);
+
+void generations_set(
+  Bitboard* b,
+  int row,
+  int col,
+  int state);
+
+void generations_load(Bitboard* b, Grid in);
+
+void generations_store(Bitboard* b, Grid out);
+
+uint64_t generations_hash(Bitboard* b);
+
+void generations_step(Bitboard* b, Rule rule);
+
+int ltl_init(
+  Ltl* l,
+  Mode mode,
+  int rows,
+  int cols);
+
+void ltl_destroy(Ltl* l);
+
+unsigned char ltl_get(
+  Ltl* l,
+  int row,
+  int col);
+
+void ltl_set(
+  Ltl* l,
+  int row,
+  int col,
+  unsigned char value);
+
+void ltl_load(Ltl* l, Grid in);
+
+void ltl_store(Ltl* l, Grid out);
+
+void ltl_step(
+  Ltl* l,
+  Pool* pool,
+  Rule rule);
+
+Box ltl_box(Ltl* l, Box within);
+
+void fft_plan(FftPlan* p, int n);
+
+void fft_destroy(FftPlan* p);
+
+int fft_scratch(const FftPlan* p);
+
+void fft_forward(
+  const FftPlan* p,
+  Complex* x,
+  Complex* scratch);
+
+void fft_inverse(
+  const FftPlan* p,
+  Complex* x,
+  Complex* scratch);
+
+int lenia_init(
+  Lenia* l,
+  Mode mode,
+  int rows,
+  int cols);
+
+void lenia_destroy(Lenia* l);
+
+float lenia_get(
+  Lenia* l,
+  int row,
+  int col);
+
+void lenia_set(
+  Lenia* l,
+  int row,
+  int col,
+  float value);
+
+void lenia_load(Lenia* l, Grid in);
+
+void lenia_store(Lenia* l, Grid out);
+
+uint64_t lenia_hash(Lenia* l);
+
+void lenia_random(
+  Lenia* l,
+  uint64_t seed,
+  double density);
+
+void lenia_step(
+  Lenia* l,
+  Pool* pool,
+  Rule rule);
+
+const Tiling* tiling_get(int index);
+
+const Tiling* tiling_find(const char* name);
+
+int graph_init(
+  Graph* g,
+  Mode mode,
+  int rows,
+  int cols);
+
+int graph_init_tiling(
+  Graph* g,
+  const Tiling* tiling,
+  int rows,
+  int cols);
+
+void graph_destroy(Graph* g);
+
+unsigned char graph_get(
+  Graph* g,
+  int row,
+  int col);
+
+void graph_set(
+  Graph* g,
+  int row,
+  int col,
+  unsigned char value);
+
+void graph_load(Graph* g, Grid in);
+
+void graph_store(Graph* g, Grid out);
+
+void graph_step(
+  Graph* g,
+  Pool* pool,
+  Rule rule);
+
+long soup_run(
+  Mode mode,
+  Rule rule,
+  long soups,
+  int size,
+  int generations,
+  uint64_t seed,
+  Pool* pool,
+  Census* out);
+
+void soup_search(
+  Mode mode,
+  long soups,
+  int size,
+  int generations,
+  const Rule* rules,
+  const char** names,
+  int count);
+
+void sweep_run(
+  Mode mode,
+  int size,
+  int generations,
+  const int (*rules)[3],
+  int rule_count,
+  const uint64_t* seeds,
+  int seed_count,
+  Pool* pool,
+  FILE* out);
+
+void sweep(
+  Mode mode,
+  int size,
+  int generations,
+  int seed_count,
+  const char* path,
+  const int (*rules)[3],
+  int rule_count);
+
+int wavefront_neighbors(
+  Mode mode,
+  int tile_rows,
+  int tile_cols,
+  int out[8][2]);
+
+void wavefront_run(
+  Bitboard* b,
+  Pool* pool,
+  Rule rule,
+  int generations);
+
+int engine_run(
+  Engine* e,
+  Rule rule,
+  int generations);
+
+int tune_class(int rows, int cols);
+
+int tune_engine(
+  Engine* e,
+  Tuning t,
+  Grid grid);
+
+Tuning tune_calibrate(
+  Mode mode,
+  int rows,
+  int cols,
+  int serial,
+  FILE* log);
+
+Tuning tune(
+  Mode mode,
+  int rows,
+  int cols,
+  Kernel fallback);
+
+Tuning tune_serial(
+  Mode mode,
+  int rows,
+  int cols,
+  Kernel fallback);
+
+void tune_world(Mode mode, int size);
+
+double now_ms();
+
+void bench(int generations);
 
 #endif
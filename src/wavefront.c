@@ -0,0 +1,188 @@
+#include "utils.h"
+
+/*
+  Wavefront stepping - generations flow through the grid without a
+  global barrier between them
+
+  Grid is cut into tiles, tile (i, j) of generation N + 1 is runnable as
+  soon as it and its neighbor tiles have finished generation N, so
+  several generations are in flight at once and no core waits for the
+  slowest tile of a generation:
+
+      done:   3 3 3 2 2 1
+              3 3 2 2 1 1      <- generations completed per tile
+              3 2 2 1 1 0
+
+  Generation N is kept in buffer N % 2. Neighbor tiles never differ by
+  more than one generation, so a tile writing N + 1 can only overwrite
+  N - 1, which no neighbor reads anymore.
+
+  Neighbor tiles are taken from the mode neighborhood itself: cells of
+  a tile are probed with neighbors_indices() and every tile they touch
+  is a dependency (hexagon tiles get only 6 of the 8 around them).
+  Tile rows are even, so row parity is the same for every tile.
+*/
+
+#define WAVEFRONT_ROWS 32
+#define WAVEFRONT_WORDS 4
+
+typedef struct Wavefront Wavefront;
+
+typedef struct{
+  Wavefront* w;
+  int index;
+} WavefrontTile;
+
+struct Wavefront{
+  Bitboard* b;
+  Pool* pool;
+  uint64_t* buffers[2];
+  int tile_rows;
+  int tile_words;
+  int rows;             // tiles per column
+  int cols;             // tiles per row
+  int neighbors[8][2];
+  int neighbors_size;
+  int generations;
+  atomic_int* done;     // generations completed by the tile
+  atomic_int* claimed;  // generation the tile is scheduled for
+  WavefrontTile* tiles;
+  _Atomic uint64_t hash; // hash change by all tiles and generations
+  Tally* tallies;       // last generation of the tile
+};
+
+int wavefront_neighbors(Mode mode, int tile_rows, int tile_cols, int out[8][2]){
+  Grid probe = {};
+  grid_init(&probe, mode, 3 * tile_rows, 3 * tile_cols);
+
+  int used[3][3] = {};
+  for(int i = tile_rows; i < 2 * tile_rows; i++)
+    for(int j = tile_cols; j < 2 * tile_cols; j++){
+      int indices[12] = {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1};
+      neighbors_indices(i, j, probe, indices);
+      for(int k = 0; k < 12; k++)
+        if(indices[k] > -1){
+          int tr = indices[k] / probe.cols / tile_rows;
+          int tc = indices[k] % probe.cols / tile_cols;
+          used[tr][tc] = 1;
+          used[2 - tr][2 - tc] = 1;   // and the tiles depending on this one
+        }
+    }
+  free(probe.data);
+
+  int size = 0;
+  for(int tr = 0; tr < 3; tr++)
+    for(int tc = 0; tc < 3; tc++)
+      if(used[tr][tc] && (tr != 1 || tc != 1)){
+        out[size][0] = tr - 1;
+        out[size][1] = tc - 1;
+        size++;
+      }
+  return size;
+}
+
+static void wavefront_tile(void* arg);
+
+static void wavefront_try(Wavefront* w, int index){
+  int g = atomic_load(&w->done[index]);
+  if(g >= w->generations || atomic_load(&w->claimed[index]) != g)
+    return;
+
+  int ti = index / w->cols, tj = index % w->cols;
+  for(int k = 0; k < w->neighbors_size; k++){
+    int ni = ti + w->neighbors[k][0], nj = tj + w->neighbors[k][1];
+    if(ni < 0 || ni >= w->rows || nj < 0 || nj >= w->cols)
+      continue;
+    if(atomic_load(&w->done[ni * w->cols + nj]) < g)
+      return;
+  }
+
+  if(atomic_compare_exchange_strong(&w->claimed[index], &g, g + 1))
+    pool_push(w->pool, wavefront_tile, &w->tiles[index]);
+}
+
+static void wavefront_tile(void* arg){
+  WavefrontTile* t = arg;
+  Wavefront* w = t->w;
+  Bitboard* b = w->b;
+  int g = atomic_load(&w->done[t->index]);
+  int ti = t->index / w->cols, tj = t->index % w->cols;
+
+  const uint64_t* src = w->buffers[g % 2];
+  uint64_t* dst = w->buffers[(g + 1) % 2];
+  int from = tj * w->tile_words;
+  int to = from + w->tile_words < b->words ? from + w->tile_words : b->words;
+
+  Tally tally = tally_empty();
+  for(int row = ti * w->tile_rows; row < (ti + 1) * w->tile_rows && row < b->rows; row++){
+    const uint64_t* c = src + (row + 1) * b->stride + 1;
+    const uint64_t* window[3] = { c - b->stride, c, c + b->stride };
+    uint64_t* out = dst + (row + 1) * b->stride + 1;
+    bitboard_step_row(b, window, out, from, to, row, b->generation + g);
+    if(to == b->words)
+      out[b->words - 1] &= b->tail;
+    if(b->hashing || b->tracking)
+      bitboard_tally_row(b, c, out, from, to, row, &tally);
+  }
+  if(tally.hash)
+    atomic_fetch_xor(&w->hash, tally.hash);
+  w->tallies[t->index] = tally;
+
+  atomic_store(&w->done[t->index], g + 1);
+
+  wavefront_try(w, t->index);
+  for(int k = 0; k < w->neighbors_size; k++){
+    int ni = ti + w->neighbors[k][0], nj = tj + w->neighbors[k][1];
+    if(ni >= 0 && ni < w->rows && nj >= 0 && nj < w->cols)
+      wavefront_try(w, ni * w->cols + nj);
+  }
+}
+
+void wavefront_run(Bitboard* b, Pool* pool, Rule rule, int generations){
+  bitboard_rule(b, rule);
+  if(generations <= 0)
+    return;
+
+  Wavefront w = {
+    .b = b,
+    .pool = pool,
+    .buffers = { b->data, b->next },
+    .tile_rows = b->tile_rows ? b->tile_rows : WAVEFRONT_ROWS,
+    .tile_words = b->tile_words ? b->tile_words : WAVEFRONT_WORDS,
+    .generations = generations
+  };
+  w.tile_rows += w.tile_rows & 1;
+  w.rows = (b->rows + w.tile_rows - 1) / w.tile_rows;
+  w.cols = (b->words + w.tile_words - 1) / w.tile_words;
+  w.neighbors_size = wavefront_neighbors(b->mode, w.tile_rows, w.tile_words * 64, w.neighbors);
+
+  int tiles = w.rows * w.cols;
+  w.done = calloc(sizeof(atomic_int), tiles);
+  w.claimed = calloc(sizeof(atomic_int), tiles);
+  w.tiles = calloc(sizeof(WavefrontTile), tiles);
+  w.tallies = calloc(sizeof(Tally), tiles);
+  for(int i = 0; i < tiles; i++)
+    w.tiles[i] = (WavefrontTile){ &w, i };
+
+  for(int i = 0; i < tiles; i++)
+    wavefront_try(&w, i);
+  pool_wait(pool);
+
+  if(generations % 2){
+    b->data = w.buffers[1];
+    b->next = w.buffers[0];
+  }
+
+  free(w.done);
+  free(w.claimed);
+  // tiles are merged here, not while running
+  b->tally = tally_empty();
+  for(int i = 0; i < tiles; i++)
+    tally_merge(&b->tally, w.tallies[i]);
+  b->tally.scanned = 1;
+  b->hash ^= atomic_load(&w.hash);
+  b->generation += generations;
+
+  free(w.tiles);
+  free(w.tallies);
+}